@@ -0,0 +1,195 @@
+use criterion::{black_box, criterion_group, criterion_main, Criterion, Throughput};
+use vi::processor::{add_tone, modify_letter, remove_tone, ToneMark, LetterModification};
+use vi::util::{clean_char, remove_tone_mark, strip_diacritics, to_search_key};
+use vi::cache::SyllableCache;
+use vi::charset::{Charset, encode, decode};
+use vi::engine::Engine;
+use vi::vni::{self, VNI};
+
+const PARAGRAPH: &str = "Vie65t Nam, quo61c hie65u chi1nh thu71c la2 Co65ng ho2a Xa4 ho65i \
+chu3 nghi4a Vie65t Nam, la2 mo65t quo61c gia nu82m o73 cu75c d9o6ng thuo65c khu vu75c \
+D9o6ng Nam A1. Vo71i die65n ti1ch 331.212 km2 va2 da6n so61 khoa3ng 100 trie65u \
+ngu7o72i, Vie65t Nam la2 quo61c gia d9o6ng da6n thu71 15 tre6n the61 gio71i.\n";
+
+fn corpus() -> String {
+    PARAGRAPH.repeat(200)
+}
+
+fn keystroke(c: &mut Criterion) {
+    let keys: Vec<char> = "nguoi72".chars().collect();
+    let mut group = c.benchmark_group("keystroke");
+    group.bench_function("transform_buffer", |b| b.iter(|| {
+        // an IME re-transforms the whole buffer after each key
+        for len in 1..=keys.len() {
+            black_box(vni::transform_buffer(&keys[..len]));
+        }
+    }));
+    group.bench_function("engine", |b| b.iter(|| {
+        let mut engine = Engine::new(&VNI);
+        for ch in &keys {
+            black_box(engine.push(*ch));
+        }
+        black_box(engine.commit())
+    }));
+    group.finish();
+}
+
+/// The same words through each engine, to follow the speed of the fast
+/// paths next to the reference they are checked against
+fn engines(c: &mut Criterion) {
+    let input = corpus();
+    let words: Vec<Vec<char>> = input
+        .split(|ch: char| !VNI.is_word_char(ch))
+        .filter(|word| !word.is_empty())
+        .map(|word| word.chars().collect())
+        .collect();
+    let mut group = c.benchmark_group("engines");
+    group.throughput(Throughput::Elements(words.len() as u64));
+    group.bench_function("reference", |b| b.iter(|| {
+        for word in &words {
+            black_box(VNI.transform_buffer_reference(word));
+        }
+    }));
+    group.bench_function("transform_buffer", |b| b.iter(|| {
+        for word in &words {
+            black_box(VNI.transform_buffer(word));
+        }
+    }));
+    group.bench_function("engine", |b| b.iter(|| {
+        let mut engine = Engine::new(&VNI);
+        for word in &words {
+            for ch in word {
+                black_box(engine.push(*ch));
+            }
+            black_box(engine.commit());
+        }
+    }));
+    let mut cache = SyllableCache::new(&VNI, 4096);
+    group.bench_function("cache", |b| b.iter(|| {
+        for word in &words {
+            black_box(cache.transform_buffer(word));
+        }
+    }));
+    group.finish();
+}
+
+fn processor(c: &mut Criterion) {
+    let words: Vec<String> = ["nguoi", "hoang", "tuyen", "vuon", "chet", "quyen"]
+        .iter()
+        .map(|word| word.to_string())
+        .collect();
+    let toned_words: Vec<String> = ["người", "hoàng", "tuyến", "vươn", "chết", "quyền"]
+        .iter()
+        .map(|word| word.to_string())
+        .collect();
+    let mut group = c.benchmark_group("processor");
+    group.throughput(Throughput::Elements(words.len() as u64));
+    group.bench_function("add_tone", |b| b.iter(|| {
+        for word in &words {
+            black_box(add_tone(word, &ToneMark::Acute));
+        }
+    }));
+    group.bench_function("modify_letter", |b| b.iter(|| {
+        for word in &words {
+            black_box(modify_letter(word, &LetterModification::Horn));
+        }
+    }));
+    group.bench_function("remove_tone", |b| b.iter(|| {
+        for word in &toned_words {
+            black_box(remove_tone(word));
+        }
+    }));
+    group.finish();
+}
+
+fn util(c: &mut Criterion) {
+    let chars: Vec<char> = "Tiếng Việt có dấu thanh điệu đầy đủ".chars().collect();
+    let mut group = c.benchmark_group("util");
+    group.throughput(Throughput::Elements(chars.len() as u64));
+    group.bench_function("clean_char", |b| b.iter(|| {
+        for ch in &chars {
+            black_box(clean_char(*ch));
+        }
+    }));
+    group.bench_function("remove_tone_mark", |b| b.iter(|| {
+        for ch in &chars {
+            black_box(remove_tone_mark(*ch));
+        }
+    }));
+    let text: String = chars.iter().collect();
+    group.bench_function("strip_diacritics", |b| b.iter(|| black_box(strip_diacritics(&text))));
+    group.bench_function("to_search_key", |b| b.iter(|| black_box(to_search_key(&text))));
+    group.finish();
+}
+
+fn document(c: &mut Criterion) {
+    let input = corpus();
+    let mut group = c.benchmark_group("document");
+    group.throughput(Throughput::Bytes(input.len() as u64));
+    group.bench_function("transform_buffer_per_word", |b| b.iter(|| {
+        let mut result = String::with_capacity(input.len());
+        for word in input.split(' ') {
+            let (_, transformed) = vni::transform_buffer(&word.chars().collect::<Vec<char>>());
+            result.push_str(&transformed);
+            result.push(' ');
+        }
+        black_box(result)
+    }));
+    group.bench_function("transform_str", |b| b.iter(|| {
+        let mut result = String::with_capacity(input.len());
+        vni::transform_str(&input, &mut result);
+        black_box(result)
+    }));
+    let mut cache = SyllableCache::new(&VNI, 4096);
+    group.bench_function("transform_str_cached", |b| b.iter(|| {
+        let mut result = String::with_capacity(input.len());
+        cache.transform_str(&input, &mut result);
+        black_box(result)
+    }));
+    let mut text = String::new();
+    vni::transform_str(&input, &mut text);
+    group.bench_function("decompose_to_keys", |b| b.iter(|| {
+        let mut result = String::with_capacity(input.len());
+        vni::decompose_to_keys(&text, &mut result);
+        black_box(result)
+    }));
+    group.finish();
+}
+
+fn untouched(c: &mut Criterion) {
+    // mostly ASCII text without any vni key, copied in runs
+    let input = "The quick brown fox jumps over the lazy dog, again and a1gain.\n".repeat(2000);
+    let mut group = c.benchmark_group("untouched");
+    group.throughput(Throughput::Bytes(input.len() as u64));
+    group.bench_function("transform_str", |b| b.iter(|| {
+        let mut result = String::with_capacity(input.len());
+        vni::transform_str(&input, &mut result);
+        black_box(result)
+    }));
+    group.finish();
+}
+
+fn charset(c: &mut Criterion) {
+    let mut text = String::new();
+    vni::transform_str(&corpus(), &mut text);
+    let mut group = c.benchmark_group("charset");
+    group.throughput(Throughput::Bytes(text.len() as u64));
+    for charset in [Charset::Tcvn3, Charset::VniWindows, Charset::Viscii].iter() {
+        let mut encoded = Vec::new();
+        encode(*charset, &text, &mut encoded);
+        group.bench_function(&format!("encode_{:?}", charset), |b| b.iter(|| {
+            let mut result = Vec::with_capacity(text.len());
+            encode(*charset, &text, &mut result);
+            black_box(result)
+        }));
+        group.bench_function(&format!("decode_{:?}", charset), |b| b.iter(|| {
+            let mut result = String::with_capacity(text.len());
+            decode(*charset, &encoded, &mut result);
+            black_box(result)
+        }));
+    }
+    group.finish();
+}
+
+criterion_group!(benches, keystroke, engines, processor, util, document, untouched, charset);
+criterion_main!(benches);
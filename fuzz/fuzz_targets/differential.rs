@@ -0,0 +1,61 @@
+//! Transform the words of arbitrary text with every input method and
+//! check the fast paths against the string processor, then the words of
+//! keystrokes against the frozen baseline of `tests/baseline`.
+//!
+//! Run with `cargo fuzz run differential`.
+
+#![no_main]
+
+#[path = "../../tests/baseline/mod.rs"]
+mod baseline;
+
+use libfuzzer_sys::fuzz_target;
+use vi::engine::Engine;
+use vi::method::{InputMethod, KeyOrder};
+use vi::{telex, viqr, vni};
+
+static VNI_TYPED: InputMethod = InputMethod::new(&vni::VNI_KEYS, KeyOrder::Typed);
+
+fn check(method: &'static InputMethod, typed: &InputMethod, keys: &[char]) {
+    assert_eq!(method.transform_buffer(keys), method.transform_buffer_reference(keys), "keys {:?}", keys);
+    if !keys.iter().all(|key| baseline::is_keystroke(*key)) {
+        return;
+    }
+    assert_eq!(method.transform_buffer(keys), baseline::transform_buffer(method, keys), "keys {:?}", keys);
+
+    let mut engine = Engine::new(method);
+    let mut screen = String::new();
+    for key in keys {
+        let delta = engine.push(*key);
+        for _ in 0..delta.backspace_count {
+            screen.pop();
+        }
+        screen.push_str(&delta.insert);
+    }
+    let (_, expected) = baseline::transform_buffer(typed, keys);
+    assert_eq!(engine.view(), expected, "keys {:?}", keys);
+    assert_eq!(screen, expected, "keys {:?}", keys);
+}
+
+fuzz_target!(|data: &[u8]| {
+    let text = match std::str::from_utf8(data) {
+        Ok(text) => text,
+        Err(_) => return
+    };
+    let methods: [(&'static InputMethod, &InputMethod); 3] = [
+        (&vni::VNI, &VNI_TYPED),
+        (&telex::TELEX, &telex::TELEX),
+        (&viqr::VIQR, &viqr::VIQR)
+    ];
+    for (method, typed) in methods.iter() {
+        let mut word = Vec::new();
+        for ch in text.chars().chain(std::iter::once(' ')) {
+            if method.is_word_char(ch) {
+                word.push(ch);
+            } else if !word.is_empty() {
+                check(method, typed, &word);
+                word.clear();
+            }
+        }
+    }
+});
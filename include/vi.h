@@ -0,0 +1,84 @@
+/*
+ * C bindings of the vi incremental engine.
+ *
+ * Build the shared and static libraries with
+ * `cargo rustc --release --features ffi --crate-type cdylib --crate-type staticlib`.
+ *
+ * Each key event returns the edit to apply on screen: delete
+ * `backspace_count` chars before the cursor, then insert the first
+ * `insert_len` bytes of the caller buffer as UTF-8 text. The text is never
+ * NUL terminated. Buffers are always owned by the caller, so nothing has to
+ * be freed but the engine itself.
+ *
+ * When the buffer is too small, the call returns VI_ERROR_BUFFER_TOO_SMALL
+ * with the required length written. The key has still been applied, its
+ * text can be fetched again with vi_engine_last_insert.
+ */
+#ifndef VI_H
+#define VI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VI_OK 0
+/* A required pointer is null */
+#define VI_ERROR_NULL -1
+/* The key is not a unicode scalar value, or the UTF-8 key is not a single char */
+#define VI_ERROR_INVALID_KEY -2
+/* The caller buffer is too small, the required length has been written */
+#define VI_ERROR_BUFFER_TOO_SMALL -3
+
+#define VI_METHOD_VNI 0
+#define VI_METHOD_TELEX 1
+#define VI_METHOD_VIQR 2
+
+#define VI_FORM_NFC 0
+#define VI_FORM_NFD 1
+
+typedef struct ViEngine ViEngine;
+
+typedef struct ViDelta {
+    size_t backspace_count;
+    size_t insert_len;
+} ViDelta;
+
+/* Create an engine, return NULL if the method or the form is unknown */
+ViEngine *vi_engine_new(uint32_t method, uint32_t form);
+
+/* Destroy an engine, NULL is ignored */
+void vi_engine_free(ViEngine *engine);
+
+/* Feed a key given as a UTF-32 code point */
+int vi_engine_push_utf32(ViEngine *engine, uint32_t key,
+                         ViDelta *delta, uint8_t *buffer, size_t capacity);
+
+/* Feed a key given as the UTF-8 bytes of a single char */
+int vi_engine_push_utf8(ViEngine *engine, const uint8_t *key, size_t key_len,
+                        ViDelta *delta, uint8_t *buffer, size_t capacity);
+
+/* Remove the last char of the word being typed */
+int vi_engine_backspace(ViEngine *engine,
+                        ViDelta *delta, uint8_t *buffer, size_t capacity);
+
+/* Copy the text inserted by the last key event again */
+int vi_engine_last_insert(const ViEngine *engine,
+                          uint8_t *buffer, size_t capacity, size_t *len);
+
+/* Copy the word being typed, always precomposed */
+int vi_engine_view(const ViEngine *engine,
+                   uint8_t *buffer, size_t capacity, size_t *len);
+
+/* Copy the word being typed in the output form and reset the engine. When
+ * the buffer is too small the word is kept and nothing is reset. */
+int vi_engine_commit(ViEngine *engine,
+                     uint8_t *buffer, size_t capacity, size_t *len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VI_H */
@@ -0,0 +1,223 @@
+use std::io;
+use std::mem;
+use std::pin::Pin;
+use std::task::{Context, Poll};
+use bytes::Bytes;
+use futures_core::{ready, Stream};
+use pin_project_lite::pin_project;
+use tokio::io::{AsyncRead, ReadBuf};
+use super::method::InputMethod;
+use super::stream::Converter;
+
+/// Bytes read from the underlying reader at once by default
+pub const DEFAULT_READ_SIZE: usize = 8 * 1024;
+
+pin_project! {
+    /// An async reader that transforms the text read from the underlying
+    /// reader with an input method, inline in the task reading it.
+    ///
+    /// The underlying reader is only read once the transformed text has
+    /// been consumed, so the buffering is bounded by one read of input,
+    /// its output and the unfinished word carried to the next read, and a
+    /// slow consumer slows the producer down.
+    ///
+    /// # Example
+    /// ```
+    /// use tokio::io::AsyncReadExt;
+    /// use vi::async_stream::TransformReader;
+    /// use vi::telex::TELEX;
+    ///
+    /// # tokio::runtime::Builder::new_current_thread().build().unwrap().block_on(async {
+    /// let mut reader = TransformReader::new(&TELEX, "xin chaof Vieetj Nam".as_bytes());
+    /// let mut result = String::new();
+    /// reader.read_to_string(&mut result).await.unwrap();
+    /// assert_eq!(result, "xin chào Việt Nam");
+    /// # });
+    /// ```
+    pub struct TransformReader<R> {
+        #[pin]
+        inner: R,
+        converter: Converter,
+        input: Box<[u8]>,
+        output: String,
+        position: usize,
+        done: bool
+    }
+}
+
+impl<R: AsyncRead> TransformReader<R> {
+    pub fn new(method: &'static InputMethod, inner: R) -> Self {
+        TransformReader::with_capacity(method, DEFAULT_READ_SIZE, inner)
+    }
+
+    /// Create a reader reading at most `capacity` bytes from `inner` at
+    /// once
+    pub fn with_capacity(method: &'static InputMethod, capacity: usize, inner: R) -> Self {
+        TransformReader {
+            inner,
+            converter: Converter::new(method),
+            input: vec![0; capacity.max(1)].into_boxed_slice(),
+            output: String::new(),
+            position: 0,
+            done: false
+        }
+    }
+
+    pub fn into_inner(self) -> R {
+        self.inner
+    }
+}
+
+impl<R: AsyncRead> AsyncRead for TransformReader<R> {
+    fn poll_read(self: Pin<&mut Self>, cx: &mut Context<'_>, buf: &mut ReadBuf<'_>) -> Poll<io::Result<()>> {
+        let mut this = self.project();
+        while *this.position == this.output.len() && !*this.done {
+            this.output.clear();
+            *this.position = 0;
+            let mut input = ReadBuf::new(this.input);
+            ready!(this.inner.as_mut().poll_read(cx, &mut input))?;
+            if input.filled().is_empty() {
+                this.converter.finish(this.output)?;
+                *this.done = true;
+            } else {
+                this.converter.feed(input.filled(), this.output)?;
+            }
+        }
+        let available = &this.output.as_bytes()[*this.position..];
+        let len = available.len().min(buf.remaining());
+        buf.put_slice(&available[..len]);
+        *this.position += len;
+        Poll::Ready(Ok(()))
+    }
+}
+
+pin_project! {
+    /// A stream that transforms the chunks of text of the underlying
+    /// stream with an input method, such as the frames of a chat
+    /// connection. A chunk ending in the middle of a word keeps the word
+    /// until the next chunk, and chunks that only continue a word yield
+    /// nothing.
+    ///
+    /// The underlying stream is only polled when this stream is, so at
+    /// most one chunk and the unfinished word are buffered.
+    ///
+    /// # Example
+    /// ```
+    /// use bytes::Bytes;
+    /// use tokio_stream::StreamExt;
+    /// use vi::async_stream::TransformStream;
+    /// use vi::vni::VNI;
+    ///
+    /// # tokio::runtime::Builder::new_current_thread().build().unwrap().block_on(async {
+    /// let chunks = tokio_stream::iter(vec![Ok(Bytes::from("xin cha")), Ok(Bytes::from("o2 ban5"))]);
+    /// let mut stream = TransformStream::new(&VNI, chunks);
+    /// assert_eq!(stream.next().await.unwrap().unwrap(), "xin ");
+    /// assert_eq!(stream.next().await.unwrap().unwrap(), "chào ");
+    /// assert_eq!(stream.next().await.unwrap().unwrap(), "bạn");
+    /// assert!(stream.next().await.is_none());
+    /// # });
+    /// ```
+    pub struct TransformStream<S> {
+        #[pin]
+        inner: S,
+        converter: Converter,
+        output: String,
+        done: bool
+    }
+}
+
+impl<S: Stream<Item = io::Result<Bytes>>> TransformStream<S> {
+    pub fn new(method: &'static InputMethod, inner: S) -> Self {
+        TransformStream {
+            inner,
+            converter: Converter::new(method),
+            output: String::new(),
+            done: false
+        }
+    }
+
+    pub fn into_inner(self) -> S {
+        self.inner
+    }
+}
+
+impl<S: Stream<Item = io::Result<Bytes>>> Stream for TransformStream<S> {
+    type Item = io::Result<Bytes>;
+
+    fn poll_next(self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<Option<Self::Item>> {
+        let mut this = self.project();
+        while !*this.done {
+            match ready!(this.inner.as_mut().poll_next(cx)) {
+                Some(Ok(chunk)) => this.converter.feed(&chunk, this.output)?,
+                Some(Err(error)) => return Poll::Ready(Some(Err(error))),
+                None => {
+                    *this.done = true;
+                    this.converter.finish(this.output)?;
+                }
+            }
+            if !this.output.is_empty() {
+                return Poll::Ready(Some(Ok(Bytes::from(mem::take(this.output)))));
+            }
+        }
+        Poll::Ready(None)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use tokio::io::AsyncReadExt;
+    use tokio_stream::StreamExt;
+    use crate::vni::VNI;
+
+    const INPUT: &str = "xin chao2 toi6 la2 Hung7, toi6 den961 tu72 Viet65 Nam\n";
+    const EXPECTED: &str = "xin chào tôi là Hưng, tôi đến từ Việt Nam\n";
+
+    /// A reader giving a few bytes at a time, not ready every other poll
+    struct SlowReader {
+        input: &'static [u8],
+        ready: bool
+    }
+
+    impl AsyncRead for SlowReader {
+        fn poll_read(mut self: Pin<&mut Self>, cx: &mut Context<'_>, buf: &mut ReadBuf<'_>) -> Poll<io::Result<()>> {
+            self.ready = !self.ready;
+            if !self.ready {
+                cx.waker().wake_by_ref();
+                return Poll::Pending;
+            }
+            let len = self.input.len().min(buf.remaining()).min(3);
+            buf.put_slice(&self.input[..len]);
+            self.input = &self.input[len..];
+            Poll::Ready(Ok(()))
+        }
+    }
+
+    #[tokio::test]
+    async fn reader_slow_input() {
+        let inner = SlowReader { input: INPUT.as_bytes(), ready: false };
+        let mut reader = TransformReader::with_capacity(&VNI, 5, inner);
+        let mut result = String::new();
+        reader.read_to_string(&mut result).await.unwrap();
+        assert_eq!(result, EXPECTED);
+    }
+
+    #[tokio::test]
+    async fn stream_chunks() {
+        let chunks: Vec<io::Result<Bytes>> = INPUT.as_bytes()
+            .chunks(4)
+            .map(|chunk| Ok(Bytes::copy_from_slice(chunk)))
+            .collect();
+        let stream = TransformStream::new(&VNI, tokio_stream::iter(chunks));
+        let result: Vec<io::Result<Bytes>> = stream.collect().await;
+        let result: Vec<u8> = result.into_iter().flat_map(|chunk| chunk.unwrap()).collect();
+        assert_eq!(String::from_utf8(result).unwrap(), EXPECTED);
+    }
+
+    #[tokio::test]
+    async fn stream_invalid_utf8() {
+        let chunks = vec![Ok(Bytes::from_static(b"chao2 \xff"))];
+        let mut stream = TransformStream::new(&VNI, tokio_stream::iter(chunks));
+        assert!(stream.next().await.unwrap().is_err());
+    }
+}
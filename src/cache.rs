@@ -0,0 +1,175 @@
+use std::collections::HashMap;
+use std::mem;
+use super::method::InputMethod;
+use super::metrics::{self, Counter};
+
+/// Hit and miss counts of a `SyllableCache`
+#[derive(Debug, PartialEq, Clone, Copy, Default)]
+pub struct CacheStats {
+    pub hits: u64,
+    pub misses: u64
+}
+
+impl CacheStats {
+    /// Ratio of lookups that were hits, 0 when nothing has been looked up
+    pub fn hit_rate(&self) -> f64 {
+        let lookups = self.hits + self.misses;
+        if lookups == 0 {
+            return 0.0;
+        }
+        self.hits as f64 / lookups as f64
+    }
+}
+
+/// A bounded cache of transformed words keyed by their raw keys, in front
+/// of an input method. Natural text reuses a small vocabulary, so most
+/// words are a single hash lookup.
+///
+/// Words are kept in two generations. When the recent one is full it
+/// becomes the old one and the previous old one is dropped, while hits
+/// in the old generation are moved back to the recent one. The cache
+/// never holds more than `capacity` words.
+///
+/// # Example
+/// ```
+/// use vi::cache::SyllableCache;
+/// use vi::vni::VNI;
+///
+/// let mut cache = SyllableCache::new(&VNI, 1024);
+/// let mut result = String::new();
+/// cache.transform_str("to6i la2 to6i", &mut result);
+/// assert_eq!(result, "tôi là tôi");
+/// assert_eq!(cache.stats().hits, 1);
+/// ```
+pub struct SyllableCache {
+    method: &'static InputMethod,
+    capacity: usize,
+    recent: HashMap<String, (bool, String)>,
+    old: HashMap<String, (bool, String)>,
+    stats: CacheStats
+}
+
+impl SyllableCache {
+    pub fn new(method: &'static InputMethod, capacity: usize) -> Self {
+        SyllableCache {
+            method,
+            capacity: capacity.max(2),
+            recent: HashMap::new(),
+            old: HashMap::new(),
+            stats: CacheStats::default()
+        }
+    }
+
+    pub fn stats(&self) -> CacheStats {
+        self.stats
+    }
+
+    /// Number of words in the cache
+    pub fn len(&self) -> usize {
+        self.recent.len() + self.old.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Drop every word and reset the statistics
+    pub fn clear(&mut self) {
+        self.recent.clear();
+        self.old.clear();
+        self.stats = CacheStats::default();
+    }
+
+    /// Transform the keys of a word and append the result to `output`.
+    /// Return if an action has been triggered.
+    pub fn transform_word_into(&mut self, keys: &str, output: &mut String) -> bool {
+        if let Some((has_action, word)) = self.recent.get(keys) {
+            self.stats.hits += 1;
+            metrics::add(Counter::CacheHits, 1);
+            output.push_str(word);
+            return *has_action;
+        }
+        if let Some(entry) = self.old.remove(keys) {
+            self.stats.hits += 1;
+            metrics::add(Counter::CacheHits, 1);
+            output.push_str(&entry.1);
+            let has_action = entry.0;
+            metrics::add(Counter::Allocations, 1);
+            self.insert(keys.to_owned(), entry);
+            return has_action;
+        }
+        self.stats.misses += 1;
+        metrics::add(Counter::CacheMisses, 1);
+        metrics::add(Counter::Allocations, 2);
+        let mut word = String::new();
+        let has_action = self.method.transform_keys_into(keys, &mut word);
+        output.push_str(&word);
+        self.insert(keys.to_owned(), (has_action, word));
+        has_action
+    }
+
+    fn insert(&mut self, keys: String, entry: (bool, String)) {
+        if self.recent.len() >= self.capacity / 2 {
+            self.old = mem::replace(&mut self.recent, HashMap::new());
+        }
+        self.recent.insert(keys, entry);
+    }
+
+    /// Same as `InputMethod::transform_buffer`, through the cache
+    pub fn transform_buffer(&mut self, buffer: &[char]) -> (bool, String) {
+        metrics::add(Counter::Allocations, 2);
+        let keys: String = buffer.iter().collect();
+        let mut content = String::new();
+        let has_action = self.transform_word_into(&keys, &mut content);
+        (has_action, content)
+    }
+
+    /// Same as `InputMethod::transform_str`, looking every word up in
+    /// the cache
+    pub fn transform_str(&mut self, input: &str, output: &mut String) {
+        let method = self.method;
+        method
+            .transform_words(input, output, |word, output| {
+                self.transform_word_into(word, output);
+                Ok(())
+            })
+            .expect("writing to a String never fails")
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::vni::{self, VNI};
+
+    #[test]
+    fn same_as_method() {
+        let input = "Viet65 Nam, quo61c hie65u chi1nh thu71c la2 Viet65 Nam";
+        let mut expected = String::new();
+        vni::transform_str(input, &mut expected);
+        let mut cache = SyllableCache::new(&VNI, 16);
+        let mut result = String::new();
+        cache.transform_str(input, &mut result);
+        assert_eq!(result, expected);
+        // words without any key, such as `Nam`, are copied without lookup
+        assert_eq!(cache.stats(), CacheStats { hits: 1, misses: 6 });
+    }
+
+    #[test]
+    fn transform_buffer_cached() {
+        let mut cache = SyllableCache::new(&VNI, 16);
+        let buffer = ['a', '1', '1'];
+        assert_eq!(cache.transform_buffer(&buffer), vni::transform_buffer(&buffer));
+        assert_eq!(cache.transform_buffer(&buffer), vni::transform_buffer(&buffer));
+        assert_eq!(cache.stats().hit_rate(), 0.5);
+    }
+
+    #[test]
+    fn bounded() {
+        let mut cache = SyllableCache::new(&VNI, 4);
+        let mut result = String::new();
+        cache.transform_str("a1 b2 c3 d4 e5 a1", &mut result);
+        assert!(cache.len() <= 4);
+        assert_eq!(result, "á b2 c3 d4 ẹ á");
+    }
+}
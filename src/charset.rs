@@ -0,0 +1,697 @@
+use std::str;
+use phf::{phf_map, Map};
+use super::decomposition::{decompose, compose, add_tone_mark, add_modification};
+use super::processor::{ToneMark, LetterModification};
+use super::util::to_lowercase;
+
+/// Byte written in place of a char the charset can't represent
+pub const REPLACEMENT: u8 = b'?';
+
+/// A legacy vietnamese encoding
+///
+/// - **Tcvn3:** TCVN3 (ABC), one byte per letter. It has no uppercase
+/// letters with a tone mark, those are written with the lowercase
+/// bytes as the uppercase `.VnH` fonts do.
+/// - **VniWindows:** The VNI font encoding, where most letters are a base
+/// letter followed by a byte carrying the modification and the tone mark.
+/// - **Viscii:** VISCII (RFC 1456), one byte per letter. Six control
+/// codes are replaced by uppercase letters.
+#[derive(Debug, PartialEq, Clone, Copy)]
+pub enum Charset {
+    Tcvn3,
+    VniWindows,
+    Viscii
+}
+
+/// Chars of the bytes 0x80 to 0xFF in TCVN3. Unused bytes are read as latin-1.
+static TCVN3_HIGH: [char; 128] = [
+    '\u{80}', '\u{81}', '\u{82}', '\u{83}', '\u{84}', '\u{85}', '\u{86}', '\u{87}',
+    '\u{88}', '\u{89}', '\u{8a}', '\u{8b}', '\u{8c}', '\u{8d}', '\u{8e}', '\u{8f}',
+    '\u{90}', '\u{91}', '\u{92}', '\u{93}', '\u{94}', '\u{95}', '\u{96}', '\u{97}',
+    '\u{98}', '\u{99}', '\u{9a}', '\u{9b}', '\u{9c}', '\u{9d}', '\u{9e}', '\u{9f}',
+    '\u{a0}', 'Ă', 'Â', 'Ê', 'Ô', 'Ơ', 'Ư', 'Đ',
+    'ă', 'â', 'ê', 'ô', 'ơ', 'ư', 'đ', '¯',
+    '°', '±', '²', '³', '´', 'à', 'ả', 'ã',
+    'á', 'ạ', 'º', 'ằ', 'ẳ', 'ẵ', 'ắ', '¿',
+    'À', 'Á', 'Â', 'Ã', 'Ä', 'Å', 'ặ', 'ầ',
+    'ẩ', 'ẫ', 'ấ', 'ậ', 'è', 'Í', 'ẻ', 'ẽ',
+    'é', 'ẹ', 'ề', 'ể', 'ễ', 'ế', 'ệ', 'ì',
+    'ỉ', 'Ù', 'Ú', 'Û', 'ĩ', 'í', 'ị', 'ò',
+    'à', 'ỏ', 'õ', 'ó', 'ọ', 'ồ', 'ổ', 'ỗ',
+    'ố', 'ộ', 'ờ', 'ở', 'ỡ', 'ớ', 'ợ', 'ù',
+    'ð', 'ủ', 'ũ', 'ú', 'ụ', 'ừ', 'ử', 'ữ',
+    'ứ', 'ự', 'ỳ', 'ỷ', 'ỹ', 'ý', 'ỵ', 'ÿ',
+];
+
+static TCVN3_ENCODE: Map<char, u8> = phf_map! {
+    'Ă' => 0xa1,
+    'Â' => 0xa2,
+    'Ê' => 0xa3,
+    'Ô' => 0xa4,
+    'Ơ' => 0xa5,
+    'Ư' => 0xa6,
+    'Đ' => 0xa7,
+    'ă' => 0xa8,
+    'â' => 0xa9,
+    'ê' => 0xaa,
+    'ô' => 0xab,
+    'ơ' => 0xac,
+    'ư' => 0xad,
+    'đ' => 0xae,
+    'à' => 0xb5,
+    'ả' => 0xb6,
+    'ã' => 0xb7,
+    'á' => 0xb8,
+    'ạ' => 0xb9,
+    'ằ' => 0xbb,
+    'ẳ' => 0xbc,
+    'ẵ' => 0xbd,
+    'ắ' => 0xbe,
+    'ặ' => 0xc6,
+    'ầ' => 0xc7,
+    'ẩ' => 0xc8,
+    'ẫ' => 0xc9,
+    'ấ' => 0xca,
+    'ậ' => 0xcb,
+    'è' => 0xcc,
+    'ẻ' => 0xce,
+    'ẽ' => 0xcf,
+    'é' => 0xd0,
+    'ẹ' => 0xd1,
+    'ề' => 0xd2,
+    'ể' => 0xd3,
+    'ễ' => 0xd4,
+    'ế' => 0xd5,
+    'ệ' => 0xd6,
+    'ì' => 0xd7,
+    'ỉ' => 0xd8,
+    'ĩ' => 0xdc,
+    'í' => 0xdd,
+    'ị' => 0xde,
+    'ò' => 0xdf,
+    'ỏ' => 0xe1,
+    'õ' => 0xe2,
+    'ó' => 0xe3,
+    'ọ' => 0xe4,
+    'ồ' => 0xe5,
+    'ổ' => 0xe6,
+    'ỗ' => 0xe7,
+    'ố' => 0xe8,
+    'ộ' => 0xe9,
+    'ờ' => 0xea,
+    'ở' => 0xeb,
+    'ỡ' => 0xec,
+    'ớ' => 0xed,
+    'ợ' => 0xee,
+    'ù' => 0xef,
+    'ủ' => 0xf1,
+    'ũ' => 0xf2,
+    'ú' => 0xf3,
+    'ụ' => 0xf4,
+    'ừ' => 0xf5,
+    'ử' => 0xf6,
+    'ữ' => 0xf7,
+    'ứ' => 0xf8,
+    'ự' => 0xf9,
+    'ỳ' => 0xfa,
+    'ỷ' => 0xfb,
+    'ỹ' => 0xfc,
+    'ý' => 0xfd,
+    'ỵ' => 0xfe,
+};
+
+/// Chars of the bytes 0x80 to 0xFF in VISCII
+static VISCII_HIGH: [char; 128] = [
+    'Ạ', 'Ắ', 'Ằ', 'Ặ', 'Ấ', 'Ầ', 'Ẩ', 'Ậ',
+    'Ẽ', 'Ẹ', 'Ế', 'Ề', 'Ể', 'Ễ', 'Ệ', 'Ố',
+    'Ồ', 'Ổ', 'Ỗ', 'Ộ', 'Ợ', 'Ớ', 'Ờ', 'Ở',
+    'Ị', 'Ỏ', 'Ọ', 'Ỉ', 'Ủ', 'Ũ', 'Ụ', 'Ỳ',
+    'Õ', 'ắ', 'ằ', 'ặ', 'ấ', 'ầ', 'ẩ', 'ậ',
+    'ẽ', 'ẹ', 'ế', 'ề', 'ể', 'ễ', 'ệ', 'ố',
+    'ồ', 'ổ', 'ỗ', 'Ỡ', 'Ơ', 'ộ', 'ờ', 'ở',
+    'ị', 'Ự', 'Ứ', 'Ừ', 'Ử', 'ơ', 'ớ', 'Ư',
+    'À', 'Á', 'Â', 'Ã', 'Ả', 'Ă', 'ẳ', 'ẵ',
+    'È', 'É', 'Ê', 'Ẻ', 'Ì', 'Í', 'Ĩ', 'ỳ',
+    'Đ', 'ứ', 'Ò', 'Ó', 'Ô', 'ạ', 'ỷ', 'ừ',
+    'ử', 'Ù', 'Ú', 'ỹ', 'ỵ', 'Ý', 'ỡ', 'ư',
+    'à', 'á', 'â', 'ã', 'ả', 'ă', 'ữ', 'ẫ',
+    'è', 'é', 'ê', 'ẻ', 'ì', 'í', 'ĩ', 'ỉ',
+    'đ', 'ự', 'ò', 'ó', 'ô', 'õ', 'ỏ', 'ọ',
+    'ụ', 'ù', 'ú', 'ũ', 'ủ', 'ý', 'ợ', 'Ữ',
+];
+
+static VISCII_ENCODE: Map<char, u8> = phf_map! {
+    'Ẳ' => 0x02,
+    'Ẵ' => 0x05,
+    'Ẫ' => 0x06,
+    'Ỷ' => 0x14,
+    'Ỹ' => 0x19,
+    'Ỵ' => 0x1e,
+    'Ạ' => 0x80,
+    'Ắ' => 0x81,
+    'Ằ' => 0x82,
+    'Ặ' => 0x83,
+    'Ấ' => 0x84,
+    'Ầ' => 0x85,
+    'Ẩ' => 0x86,
+    'Ậ' => 0x87,
+    'Ẽ' => 0x88,
+    'Ẹ' => 0x89,
+    'Ế' => 0x8a,
+    'Ề' => 0x8b,
+    'Ể' => 0x8c,
+    'Ễ' => 0x8d,
+    'Ệ' => 0x8e,
+    'Ố' => 0x8f,
+    'Ồ' => 0x90,
+    'Ổ' => 0x91,
+    'Ỗ' => 0x92,
+    'Ộ' => 0x93,
+    'Ợ' => 0x94,
+    'Ớ' => 0x95,
+    'Ờ' => 0x96,
+    'Ở' => 0x97,
+    'Ị' => 0x98,
+    'Ỏ' => 0x99,
+    'Ọ' => 0x9a,
+    'Ỉ' => 0x9b,
+    'Ủ' => 0x9c,
+    'Ũ' => 0x9d,
+    'Ụ' => 0x9e,
+    'Ỳ' => 0x9f,
+    'Õ' => 0xa0,
+    'ắ' => 0xa1,
+    'ằ' => 0xa2,
+    'ặ' => 0xa3,
+    'ấ' => 0xa4,
+    'ầ' => 0xa5,
+    'ẩ' => 0xa6,
+    'ậ' => 0xa7,
+    'ẽ' => 0xa8,
+    'ẹ' => 0xa9,
+    'ế' => 0xaa,
+    'ề' => 0xab,
+    'ể' => 0xac,
+    'ễ' => 0xad,
+    'ệ' => 0xae,
+    'ố' => 0xaf,
+    'ồ' => 0xb0,
+    'ổ' => 0xb1,
+    'ỗ' => 0xb2,
+    'Ỡ' => 0xb3,
+    'Ơ' => 0xb4,
+    'ộ' => 0xb5,
+    'ờ' => 0xb6,
+    'ở' => 0xb7,
+    'ị' => 0xb8,
+    'Ự' => 0xb9,
+    'Ứ' => 0xba,
+    'Ừ' => 0xbb,
+    'Ử' => 0xbc,
+    'ơ' => 0xbd,
+    'ớ' => 0xbe,
+    'Ư' => 0xbf,
+    'À' => 0xc0,
+    'Á' => 0xc1,
+    'Â' => 0xc2,
+    'Ã' => 0xc3,
+    'Ả' => 0xc4,
+    'Ă' => 0xc5,
+    'ẳ' => 0xc6,
+    'ẵ' => 0xc7,
+    'È' => 0xc8,
+    'É' => 0xc9,
+    'Ê' => 0xca,
+    'Ẻ' => 0xcb,
+    'Ì' => 0xcc,
+    'Í' => 0xcd,
+    'Ĩ' => 0xce,
+    'ỳ' => 0xcf,
+    'Đ' => 0xd0,
+    'ứ' => 0xd1,
+    'Ò' => 0xd2,
+    'Ó' => 0xd3,
+    'Ô' => 0xd4,
+    'ạ' => 0xd5,
+    'ỷ' => 0xd6,
+    'ừ' => 0xd7,
+    'ử' => 0xd8,
+    'Ù' => 0xd9,
+    'Ú' => 0xda,
+    'ỹ' => 0xdb,
+    'ỵ' => 0xdc,
+    'Ý' => 0xdd,
+    'ỡ' => 0xde,
+    'ư' => 0xdf,
+    'à' => 0xe0,
+    'á' => 0xe1,
+    'â' => 0xe2,
+    'ã' => 0xe3,
+    'ả' => 0xe4,
+    'ă' => 0xe5,
+    'ữ' => 0xe6,
+    'ẫ' => 0xe7,
+    'è' => 0xe8,
+    'é' => 0xe9,
+    'ê' => 0xea,
+    'ẻ' => 0xeb,
+    'ì' => 0xec,
+    'í' => 0xed,
+    'ĩ' => 0xee,
+    'ỉ' => 0xef,
+    'đ' => 0xf0,
+    'ự' => 0xf1,
+    'ò' => 0xf2,
+    'ó' => 0xf3,
+    'ô' => 0xf4,
+    'õ' => 0xf5,
+    'ỏ' => 0xf6,
+    'ọ' => 0xf7,
+    'ụ' => 0xf8,
+    'ù' => 0xf9,
+    'ú' => 0xfa,
+    'ũ' => 0xfb,
+    'ủ' => 0xfc,
+    'ý' => 0xfd,
+    'ợ' => 0xfe,
+    'Ữ' => 0xff,
+};
+
+fn viscii_low(byte: u8) -> char {
+    match byte {
+        0x02 => 'Ẳ',
+        0x05 => 'Ẵ',
+        0x06 => 'Ẫ',
+        0x14 => 'Ỷ',
+        0x19 => 'Ỹ',
+        0x1e => 'Ỵ',
+        _ => byte as char
+    }
+}
+
+/// Check if an ASCII byte stands for itself in the charset
+fn is_plain_ascii(charset: Charset, byte: u8) -> bool {
+    byte.is_ascii() && match charset {
+        Charset::Viscii => viscii_low(byte) == byte as char,
+        _ => true
+    }
+}
+
+/// Letters written with a single byte in vni, lowercase.
+/// The uppercase byte is 0x20 lower.
+fn vni_letter(byte: u8) -> Option<char> {
+    match byte {
+        0xf1 => Some('đ'),
+        0xf4 => Some('ơ'),
+        0xf6 => Some('ư'),
+        0xed => Some('í'),
+        0xec => Some('ì'),
+        0xe6 => Some('ỉ'),
+        0xf3 => Some('ĩ'),
+        0xf2 => Some('ị'),
+        0xee => Some('ỵ'),
+        _ => None
+    }
+}
+
+/// The reverse of `vni_letter`
+fn vni_letter_byte(ch: char) -> Option<u8> {
+    match ch {
+        'đ' => Some(0xf1),
+        'ơ' => Some(0xf4),
+        'ư' => Some(0xf6),
+        'í' => Some(0xed),
+        'ì' => Some(0xec),
+        'ỉ' => Some(0xe6),
+        'ĩ' => Some(0xf3),
+        'ị' => Some(0xf2),
+        'ỵ' => Some(0xee),
+        _ => None
+    }
+}
+
+/// Bytes that follow a letter in vni, lowercase.
+/// The uppercase byte is 0x20 lower.
+fn vni_mark(byte: u8) -> Option<(Option<LetterModification>, Option<ToneMark>)> {
+    use LetterModification::*;
+    use ToneMark::*;
+    match byte {
+        0xf9 => Some((None, Some(Acute))),
+        0xf8 => Some((None, Some(Grave))),
+        0xfb => Some((None, Some(HookAbove))),
+        0xf5 => Some((None, Some(Tilde))),
+        0xef => Some((None, Some(Underdot))),
+        0xe2 => Some((Some(Circumflex), None)),
+        0xe1 => Some((Some(Circumflex), Some(Acute))),
+        0xe0 => Some((Some(Circumflex), Some(Grave))),
+        0xe5 => Some((Some(Circumflex), Some(HookAbove))),
+        0xe3 => Some((Some(Circumflex), Some(Tilde))),
+        0xe4 => Some((Some(Circumflex), Some(Underdot))),
+        0xea => Some((Some(Breve), None)),
+        0xe9 => Some((Some(Breve), Some(Acute))),
+        0xe8 => Some((Some(Breve), Some(Grave))),
+        0xfa => Some((Some(Breve), Some(HookAbove))),
+        0xfc => Some((Some(Breve), Some(Tilde))),
+        0xeb => Some((Some(Breve), Some(Underdot))),
+        _ => None
+    }
+}
+
+/// The reverse of `vni_mark`
+fn vni_mark_byte(modification: Option<LetterModification>, tone_mark: Option<ToneMark>) -> Option<u8> {
+    use LetterModification::*;
+    use ToneMark::*;
+    match (modification, tone_mark) {
+        (None, Some(Acute)) => Some(0xf9),
+        (None, Some(Grave)) => Some(0xf8),
+        (None, Some(HookAbove)) => Some(0xfb),
+        (None, Some(Tilde)) => Some(0xf5),
+        (None, Some(Underdot)) => Some(0xef),
+        (Some(Circumflex), None) => Some(0xe2),
+        (Some(Circumflex), Some(Acute)) => Some(0xe1),
+        (Some(Circumflex), Some(Grave)) => Some(0xe0),
+        (Some(Circumflex), Some(HookAbove)) => Some(0xe5),
+        (Some(Circumflex), Some(Tilde)) => Some(0xe3),
+        (Some(Circumflex), Some(Underdot)) => Some(0xe4),
+        (Some(Breve), None) => Some(0xea),
+        (Some(Breve), Some(Acute)) => Some(0xe9),
+        (Some(Breve), Some(Grave)) => Some(0xe8),
+        (Some(Breve), Some(HookAbove)) => Some(0xfa),
+        (Some(Breve), Some(Tilde)) => Some(0xfc),
+        (Some(Breve), Some(Underdot)) => Some(0xeb),
+        _ => None
+    }
+}
+
+/// Fold an uppercase vni byte to its lowercase byte
+fn vni_lowercase(byte: u8) -> u8 {
+    if (0xc0..0xe0).contains(&byte) { byte + 0x20 } else { byte }
+}
+
+fn vni_decode_letter(byte: u8) -> char {
+    match vni_letter(vni_lowercase(byte)) {
+        Some(letter) if byte < 0xe0 => letter.to_uppercase().next().unwrap_or(letter),
+        Some(letter) => letter,
+        None => byte as char
+    }
+}
+
+/// Apply the modification and tone mark of a vni mark byte to a letter.
+/// Return `None` if the letter can't take them.
+fn vni_apply_mark(letter: char, mark: (Option<LetterModification>, Option<ToneMark>)) -> Option<char> {
+    let (base, letter_modification, letter_tone_mark) = decompose(letter);
+    if letter_tone_mark.is_some() {
+        return None;
+    }
+    let modified = match (mark.0, letter_modification) {
+        (Some(modification), None) => add_modification(base, &modification)?,
+        (Some(_), Some(_)) => return None,
+        (None, _) => letter
+    };
+    match mark.1 {
+        Some(tone_mark) => add_tone_mark(modified, &tone_mark),
+        None => Some(modified)
+    }
+}
+
+/// Decode the char at the start of `src`, along with the number of bytes
+/// it takes. Return `None` if more input is needed to know, which only
+/// happens in vni when `last` is false.
+fn decode_char(charset: Charset, src: &[u8], last: bool) -> Option<(char, usize)> {
+    let byte = src[0];
+    match charset {
+        Charset::Tcvn3 if byte < 0x80 => Some((byte as char, 1)),
+        Charset::Tcvn3 => Some((TCVN3_HIGH[(byte - 0x80) as usize], 1)),
+        Charset::Viscii if byte < 0x80 => Some((viscii_low(byte), 1)),
+        Charset::Viscii => Some((VISCII_HIGH[(byte - 0x80) as usize], 1)),
+        Charset::VniWindows => {
+            let letter = vni_decode_letter(byte);
+            let mark = match src.get(1) {
+                Some(next) => vni_mark(vni_lowercase(*next)),
+                None if !last && letter.is_alphabetic() => return None,
+                None => None
+            };
+            match mark.and_then(|mark| vni_apply_mark(letter, mark)) {
+                Some(marked) => Some((marked, 2)),
+                None => Some((letter, 1))
+            }
+        }
+    }
+}
+
+/// Encode a char into `buffer`, return the number of bytes written
+fn encode_char(charset: Charset, ch: char, buffer: &mut [u8; 2]) -> usize {
+    let encoded = match charset {
+        Charset::Tcvn3 => TCVN3_ENCODE.get(&ch).or_else(|| TCVN3_ENCODE.get(&to_lowercase(ch).0)),
+        Charset::Viscii => VISCII_ENCODE.get(&ch),
+        Charset::VniWindows => return encode_vni_char(ch, buffer)
+    };
+    buffer[0] = match encoded {
+        Some(byte) => *byte,
+        None if (ch as u32) < 0x80 => ch as u8,
+        None => REPLACEMENT
+    };
+    1
+}
+
+fn encode_vni_char(ch: char, buffer: &mut [u8; 2]) -> usize {
+    let (lower, is_uppercase) = to_lowercase(ch);
+    let case = |byte: u8| if is_uppercase { byte - 0x20 } else { byte };
+    if ch.is_ascii() {
+        buffer[0] = ch as u8;
+        return 1;
+    }
+    if let Some(byte) = vni_letter_byte(lower) {
+        buffer[0] = case(byte);
+        return 1;
+    }
+    let (base, modification, tone_mark) = decompose(ch);
+    let (letter, mark) = match modification {
+        Some(LetterModification::Horn) => {
+            let horn = compose(base, modification, None);
+            (vni_letter_byte(to_lowercase(horn).0).map(case), vni_mark_byte(None, tone_mark))
+        }
+        _ if base.is_ascii() && base != ch => {
+            (Some(base as u8), vni_mark_byte(modification, tone_mark))
+        }
+        _ => (None, None)
+    };
+    match (letter, mark, tone_mark) {
+        (Some(letter), Some(mark), _) => {
+            buffer[0] = letter;
+            buffer[1] = case(mark);
+            2
+        }
+        (Some(letter), None, None) => {
+            buffer[0] = letter;
+            1
+        }
+        _ => {
+            buffer[0] = REPLACEMENT;
+            1
+        }
+    }
+}
+
+/// Decode legacy encoded bytes from `src` into UTF-8 in `dst` without
+/// allocating. Return the number of bytes read and written. Decoding
+/// stops when `dst` is full. Unless `last` is set, a letter ending `src`
+/// is left unread since its mark may be in the next buffer.
+///
+/// # Example
+/// ```
+/// use vi::charset::{Charset, decode_to_utf8};
+///
+/// let mut dst = [0; 32];
+/// let (read, written) = decode_to_utf8(Charset::VniWindows, b"Vie\xe4t Nam", &mut dst, true);
+/// assert_eq!(read, 9);
+/// assert_eq!(std::str::from_utf8(&dst[..written]).unwrap(), "Việt Nam");
+/// ```
+pub fn decode_to_utf8(charset: Charset, src: &[u8], dst: &mut [u8], last: bool) -> (usize, usize) {
+    let (mut read, mut written) = (0, 0);
+    while read < src.len() {
+        let run = ascii_run(charset, &src[read..], last).min(dst.len() - written);
+        if run > 0 {
+            dst[written..written + run].copy_from_slice(&src[read..read + run]);
+            read += run;
+            written += run;
+            continue;
+        }
+        let (ch, len) = match decode_char(charset, &src[read..], last) {
+            Some(decoded) => decoded,
+            None => break
+        };
+        if dst.len() - written < ch.len_utf8() {
+            break;
+        }
+        ch.encode_utf8(&mut dst[written..]);
+        read += len;
+        written += ch.len_utf8();
+    }
+    (read, written)
+}
+
+/// Length of the run of bytes at the start of `src` that decode to
+/// themselves. In vni, the last letter of the run is left out when a mark
+/// may follow it.
+fn ascii_run(charset: Charset, src: &[u8], last: bool) -> usize {
+    let run = src.iter().take_while(|byte| is_plain_ascii(charset, **byte)).count();
+    let is_cut = run < src.len() || !last;
+    if charset == Charset::VniWindows && run > 0 && is_cut && src[run - 1].is_ascii_alphabetic() {
+        return run - 1;
+    }
+    run
+}
+
+/// Decode a whole legacy encoded text and append it to `output`
+///
+/// # Example
+/// ```
+/// use vi::charset::{Charset, decode};
+///
+/// let mut result = String::new();
+/// decode(Charset::Tcvn3, b"ti\xd5ng vi\xd6t", &mut result);
+/// assert_eq!(result, "tiếng việt");
+/// ```
+pub fn decode(charset: Charset, src: &[u8], output: &mut String) {
+    output.reserve(src.len());
+    let mut read = 0;
+    while read < src.len() {
+        let run = ascii_run(charset, &src[read..], true);
+        if run > 0 {
+            output.push_str(str::from_utf8(&src[read..read + run]).unwrap());
+            read += run;
+            continue;
+        }
+        let (ch, len) = decode_char(charset, &src[read..], true).unwrap();
+        output.push(ch);
+        read += len;
+    }
+}
+
+/// Encode UTF-8 text from `src` into the legacy encoding in `dst` without
+/// allocating. Return the number of bytes read and written. Encoding
+/// stops when `dst` is full. The text is expected to be precomposed (NFC),
+/// chars that can't be represented are written as `REPLACEMENT`.
+///
+/// # Example
+/// ```
+/// use vi::charset::{Charset, encode_from_utf8};
+///
+/// let mut dst = [0; 32];
+/// let (_, written) = encode_from_utf8(Charset::VniWindows, "được", &mut dst);
+/// assert_eq!(&dst[..written], b"\xf1\xf6\xf4\xefc");
+/// ```
+pub fn encode_from_utf8(charset: Charset, src: &str, dst: &mut [u8]) -> (usize, usize) {
+    let (mut read, mut written) = (0, 0);
+    let mut buffer = [0; 2];
+    for ch in src.chars() {
+        let len = encode_char(charset, ch, &mut buffer);
+        if dst.len() - written < len {
+            break;
+        }
+        dst[written..written + len].copy_from_slice(&buffer[..len]);
+        read += ch.len_utf8();
+        written += len;
+    }
+    (read, written)
+}
+
+/// Encode a whole text in the legacy encoding and append it to `output`
+pub fn encode(charset: Charset, src: &str, output: &mut Vec<u8>) {
+    output.reserve(src.len());
+    let mut buffer = [0; 2];
+    for ch in src.chars() {
+        let len = encode_char(charset, ch, &mut buffer);
+        output.extend_from_slice(&buffer[..len]);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::decomposition::DECOMPOSITION_MAP;
+    use crate::util::to_uppercase;
+
+    /// Every vietnamese letter with a diacritic, in both cases
+    fn letters() -> impl Iterator<Item = char> {
+        DECOMPOSITION_MAP.keys().flat_map(|letter| vec![*letter, to_uppercase(*letter)])
+    }
+
+    fn round_trip(charset: Charset, text: &str) -> String {
+        let mut bytes = Vec::new();
+        encode(charset, text, &mut bytes);
+        let mut result = String::new();
+        decode(charset, &bytes, &mut result);
+        result
+    }
+
+    #[test]
+    fn vni_reverse_tables() {
+        for byte in 0xe0..=0xff {
+            if let Some(letter) = vni_letter(byte) {
+                assert_eq!(vni_letter_byte(letter), Some(byte));
+            }
+            if let Some((modification, tone_mark)) = vni_mark(byte) {
+                assert_eq!(vni_mark_byte(modification, tone_mark), Some(byte));
+            }
+        }
+    }
+
+    #[test]
+    fn viscii_every_letter() {
+        for letter in letters() {
+            let text = letter.to_string();
+            assert_eq!(round_trip(Charset::Viscii, &text), text);
+        }
+    }
+
+    #[test]
+    fn vni_every_letter() {
+        for letter in letters() {
+            let text = format!("x{}y", letter);
+            assert_eq!(round_trip(Charset::VniWindows, &text), text);
+        }
+    }
+
+    #[test]
+    fn tcvn3_lowercase_letters() {
+        for letter in DECOMPOSITION_MAP.keys() {
+            let text = letter.to_string();
+            assert_eq!(round_trip(Charset::Tcvn3, &text), text);
+        }
+        assert_eq!(round_trip(Charset::Tcvn3, "ĐƯỜNG"), "ĐƯờNG");
+    }
+
+    #[test]
+    fn vni_decode_text() {
+        let mut result = String::new();
+        decode(Charset::VniWindows, b"Ng\xf6\xf4\xf8i VIE\xc4T \xf1\xf6\xf4\xefc", &mut result);
+        assert_eq!(result, "Người VIỆT được");
+    }
+
+    #[test]
+    fn vni_decode_split_buffer() {
+        let src = b"Vie\xe4t";
+        let mut dst = [0; 16];
+        let (read, written) = decode_to_utf8(Charset::VniWindows, &src[..3], &mut dst, false);
+        assert_eq!((read, written), (2, 2));
+        let (read, _) = decode_to_utf8(Charset::VniWindows, &src[read..], &mut dst[written..], true);
+        assert_eq!(read, 3);
+        assert_eq!(str::from_utf8(&dst[..written + 4]).unwrap(), "Việt");
+    }
+
+    #[test]
+    fn encode_small_buffer() {
+        let mut dst = [0; 3];
+        assert_eq!(encode_from_utf8(Charset::VniWindows, "việt", &mut dst), (2, 2));
+        assert_eq!(&dst[..2], b"vi");
+    }
+
+    #[test]
+    fn encode_replacement() {
+        let mut bytes = Vec::new();
+        encode(Charset::Viscii, "a€", &mut bytes);
+        assert_eq!(bytes, b"a?");
+    }
+}
@@ -0,0 +1,206 @@
+use phf::{phf_map, Map};
+use super::processor::{ToneMark, LetterModification};
+use super::util::{to_lowercase, to_uppercase};
+use super::maps::{
+    ACCUTE_MAP, GRAVE_MAP, HOOK_ABOVE_MAP, TILDE_MAP, DOT_MAP,
+    CIRCUMFLEX_MAP, DYET_MAP, HORN_MAP, BREVE_MAP
+};
+
+/// A letter broken down into its base latin letter, the modification applied
+/// to it and its tone mark.
+pub type Decomposition = (char, Option<LetterModification>, Option<ToneMark>);
+
+/// Every lowercase vietnamese letter that carries a modification or a tone
+/// mark, mapped to its decomposition. Plain latin letters are not listed,
+/// uppercase letters are looked up through their lowercase form.
+pub static DECOMPOSITION_MAP: Map<char, Decomposition> = phf_map! {
+    'á' => ('a', None, Some(ToneMark::Acute)),
+    'à' => ('a', None, Some(ToneMark::Grave)),
+    'ả' => ('a', None, Some(ToneMark::HookAbove)),
+    'ã' => ('a', None, Some(ToneMark::Tilde)),
+    'ạ' => ('a', None, Some(ToneMark::Underdot)),
+    'ă' => ('a', Some(LetterModification::Breve), None),
+    'ắ' => ('a', Some(LetterModification::Breve), Some(ToneMark::Acute)),
+    'ằ' => ('a', Some(LetterModification::Breve), Some(ToneMark::Grave)),
+    'ẳ' => ('a', Some(LetterModification::Breve), Some(ToneMark::HookAbove)),
+    'ẵ' => ('a', Some(LetterModification::Breve), Some(ToneMark::Tilde)),
+    'ặ' => ('a', Some(LetterModification::Breve), Some(ToneMark::Underdot)),
+    'â' => ('a', Some(LetterModification::Circumflex), None),
+    'ấ' => ('a', Some(LetterModification::Circumflex), Some(ToneMark::Acute)),
+    'ầ' => ('a', Some(LetterModification::Circumflex), Some(ToneMark::Grave)),
+    'ẩ' => ('a', Some(LetterModification::Circumflex), Some(ToneMark::HookAbove)),
+    'ẫ' => ('a', Some(LetterModification::Circumflex), Some(ToneMark::Tilde)),
+    'ậ' => ('a', Some(LetterModification::Circumflex), Some(ToneMark::Underdot)),
+    'é' => ('e', None, Some(ToneMark::Acute)),
+    'è' => ('e', None, Some(ToneMark::Grave)),
+    'ẻ' => ('e', None, Some(ToneMark::HookAbove)),
+    'ẽ' => ('e', None, Some(ToneMark::Tilde)),
+    'ẹ' => ('e', None, Some(ToneMark::Underdot)),
+    'ê' => ('e', Some(LetterModification::Circumflex), None),
+    'ế' => ('e', Some(LetterModification::Circumflex), Some(ToneMark::Acute)),
+    'ề' => ('e', Some(LetterModification::Circumflex), Some(ToneMark::Grave)),
+    'ể' => ('e', Some(LetterModification::Circumflex), Some(ToneMark::HookAbove)),
+    'ễ' => ('e', Some(LetterModification::Circumflex), Some(ToneMark::Tilde)),
+    'ệ' => ('e', Some(LetterModification::Circumflex), Some(ToneMark::Underdot)),
+    'í' => ('i', None, Some(ToneMark::Acute)),
+    'ì' => ('i', None, Some(ToneMark::Grave)),
+    'ỉ' => ('i', None, Some(ToneMark::HookAbove)),
+    'ĩ' => ('i', None, Some(ToneMark::Tilde)),
+    'ị' => ('i', None, Some(ToneMark::Underdot)),
+    'ó' => ('o', None, Some(ToneMark::Acute)),
+    'ò' => ('o', None, Some(ToneMark::Grave)),
+    'ỏ' => ('o', None, Some(ToneMark::HookAbove)),
+    'õ' => ('o', None, Some(ToneMark::Tilde)),
+    'ọ' => ('o', None, Some(ToneMark::Underdot)),
+    'ô' => ('o', Some(LetterModification::Circumflex), None),
+    'ố' => ('o', Some(LetterModification::Circumflex), Some(ToneMark::Acute)),
+    'ồ' => ('o', Some(LetterModification::Circumflex), Some(ToneMark::Grave)),
+    'ổ' => ('o', Some(LetterModification::Circumflex), Some(ToneMark::HookAbove)),
+    'ỗ' => ('o', Some(LetterModification::Circumflex), Some(ToneMark::Tilde)),
+    'ộ' => ('o', Some(LetterModification::Circumflex), Some(ToneMark::Underdot)),
+    'ơ' => ('o', Some(LetterModification::Horn), None),
+    'ớ' => ('o', Some(LetterModification::Horn), Some(ToneMark::Acute)),
+    'ờ' => ('o', Some(LetterModification::Horn), Some(ToneMark::Grave)),
+    'ở' => ('o', Some(LetterModification::Horn), Some(ToneMark::HookAbove)),
+    'ỡ' => ('o', Some(LetterModification::Horn), Some(ToneMark::Tilde)),
+    'ợ' => ('o', Some(LetterModification::Horn), Some(ToneMark::Underdot)),
+    'ú' => ('u', None, Some(ToneMark::Acute)),
+    'ù' => ('u', None, Some(ToneMark::Grave)),
+    'ủ' => ('u', None, Some(ToneMark::HookAbove)),
+    'ũ' => ('u', None, Some(ToneMark::Tilde)),
+    'ụ' => ('u', None, Some(ToneMark::Underdot)),
+    'ư' => ('u', Some(LetterModification::Horn), None),
+    'ứ' => ('u', Some(LetterModification::Horn), Some(ToneMark::Acute)),
+    'ừ' => ('u', Some(LetterModification::Horn), Some(ToneMark::Grave)),
+    'ử' => ('u', Some(LetterModification::Horn), Some(ToneMark::HookAbove)),
+    'ữ' => ('u', Some(LetterModification::Horn), Some(ToneMark::Tilde)),
+    'ự' => ('u', Some(LetterModification::Horn), Some(ToneMark::Underdot)),
+    'ý' => ('y', None, Some(ToneMark::Acute)),
+    'ỳ' => ('y', None, Some(ToneMark::Grave)),
+    'ỷ' => ('y', None, Some(ToneMark::HookAbove)),
+    'ỹ' => ('y', None, Some(ToneMark::Tilde)),
+    'ỵ' => ('y', None, Some(ToneMark::Underdot)),
+    'đ' => ('d', Some(LetterModification::Dyet), None),
+};
+
+/// Get the tone mark map used to place a tone mark on a lowercase letter
+pub fn tone_mark_map(tone_mark: &ToneMark) -> &'static Map<char, char> {
+    match tone_mark {
+        ToneMark::Acute     => &ACCUTE_MAP,
+        ToneMark::Grave     => &GRAVE_MAP,
+        ToneMark::HookAbove => &HOOK_ABOVE_MAP,
+        ToneMark::Tilde     => &TILDE_MAP,
+        ToneMark::Underdot  => &DOT_MAP
+    }
+}
+
+/// Get the modification map used to modify a lowercase letter
+pub fn modification_map(modification: &LetterModification) -> &'static Map<char, char> {
+    match modification {
+        LetterModification::Horn       => &HORN_MAP,
+        LetterModification::Breve      => &BREVE_MAP,
+        LetterModification::Circumflex => &CIRCUMFLEX_MAP,
+        LetterModification::Dyet       => &DYET_MAP
+    }
+}
+
+/// Look a letter up in a table of lowercase letters, keeping its case
+fn map_letter(map: &Map<char, char>, ch: char) -> Option<char> {
+    let (letter, is_uppercase) = to_lowercase(ch);
+    let mapped = *map.get(&letter)?;
+    Some(if is_uppercase { to_uppercase(mapped) } else { mapped })
+}
+
+/// Place a tone mark on a letter without one, in either case.
+/// Return `None` if the letter can't take it.
+pub fn add_tone_mark(ch: char, tone_mark: &ToneMark) -> Option<char> {
+    map_letter(tone_mark_map(tone_mark), ch)
+}
+
+/// Modify a letter without tone mark or modification, in either case.
+/// Return `None` if the letter can't take the modification.
+pub fn add_modification(ch: char, modification: &LetterModification) -> Option<char> {
+    map_letter(modification_map(modification), ch)
+}
+
+/// Decompose a letter into its base letter, modification and tone mark.
+/// A letter without any diacritic decompose to itself. The base letter
+/// keeps the case of the letter.
+///
+/// # Example
+/// ```
+/// use vi::decomposition::decompose;
+/// use vi::processor::{ToneMark, LetterModification};
+///
+/// assert_eq!(decompose('ấ'), ('a', Some(LetterModification::Circumflex), Some(ToneMark::Acute)));
+/// assert_eq!(decompose('Ê'), ('E', Some(LetterModification::Circumflex), None));
+/// assert_eq!(decompose('b'), ('b', None, None));
+/// ```
+pub fn decompose(ch: char) -> Decomposition {
+    if ch.is_ascii() {
+        return (ch, None, None);
+    }
+    let (letter, is_uppercase) = to_lowercase(ch);
+    match DECOMPOSITION_MAP.get(&letter) {
+        Some((base, modification, tone_mark)) if is_uppercase => {
+            (base.to_ascii_uppercase(), *modification, *tone_mark)
+        }
+        Some(decomposition) => *decomposition,
+        None => (ch, None, None)
+    }
+}
+
+/// Build a letter back from its base letter, modification and tone mark,
+/// in the case of the base letter. Any part that can't be applied to the
+/// letter is ignored.
+pub fn compose(
+    base: char,
+    modification: Option<LetterModification>,
+    tone_mark: Option<ToneMark>
+) -> char {
+    let (letter, is_uppercase) = to_lowercase(base);
+    let modified = match modification {
+        Some(modification) => *modification_map(&modification).get(&letter).unwrap_or(&letter),
+        None => letter
+    };
+    let composed = match tone_mark {
+        Some(tone_mark) => *tone_mark_map(&tone_mark).get(&modified).unwrap_or(&modified),
+        None => modified
+    };
+    if is_uppercase { to_uppercase(composed) } else { composed }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn decompose_plain_letter() {
+        assert_eq!(decompose('a'), ('a', None, None));
+        assert_eq!(decompose('1'), ('1', None, None));
+    }
+
+    #[test]
+    fn decompose_uppercase() {
+        let expected = ('O', Some(LetterModification::Horn), Some(ToneMark::Tilde));
+        assert_eq!(decompose('Ỡ'), expected);
+    }
+
+    #[test]
+    fn compose_round_trip() {
+        for (ch, (base, modification, tone_mark)) in DECOMPOSITION_MAP.entries() {
+            assert_eq!(compose(*base, *modification, *tone_mark), *ch);
+            let upper_ch = to_uppercase(*ch);
+            assert_eq!(decompose(upper_ch), (base.to_ascii_uppercase(), *modification, *tone_mark));
+            assert_eq!(compose(base.to_ascii_uppercase(), *modification, *tone_mark), upper_ch);
+        }
+    }
+
+    #[test]
+    fn add_marks_keep_case() {
+        assert_eq!(add_tone_mark('Ê', &ToneMark::Acute), Some('Ế'));
+        assert_eq!(add_tone_mark('ê', &ToneMark::Acute), Some('ế'));
+        assert_eq!(add_modification('D', &LetterModification::Dyet), Some('Đ'));
+        assert_eq!(add_modification('b', &LetterModification::Horn), None);
+    }
+}
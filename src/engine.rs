@@ -0,0 +1,666 @@
+use phf::Map;
+use std::borrow::Cow;
+use std::fmt::{self, Write};
+use std::mem;
+use super::syllable::{Snapshot, Syllable, ToneStyle};
+use super::inline::InlineString;
+use super::method::InputMethod;
+use super::metrics::{self, Counter};
+use super::normalize::{Form, to_nfd, write_nfd};
+use super::processor::{Action, ToneMark, apply_action, extract_tone};
+use super::validation::is_valid_prefix;
+
+/// Keys of an input method mapped to the actions they trigger. When a key
+/// maps to several actions, the first one that can be applied is used.
+pub type KeyMap = Map<char, &'static [Action]>;
+
+/// The minimal edit a frontend has to send to update the text on screen:
+/// delete `backspace_count` chars then type `insert`.
+#[derive(Debug, PartialEq, Clone, Default)]
+pub struct Delta {
+    pub backspace_count: usize,
+    pub insert: InlineString
+}
+
+impl Delta {
+    /// Compute the edit that turns `old` into `new`. Only the part after
+    /// the longest common prefix is replaced.
+    ///
+    /// # Example
+    /// ```
+    /// use vi::engine::Delta;
+    ///
+    /// let delta = Delta::between("viet", "việt");
+    /// assert_eq!(delta.backspace_count, 2);
+    /// assert_eq!(delta.insert, "ệt");
+    /// ```
+    pub fn between(old: &str, new: &str) -> Delta {
+        let mut prefix_len = 0;
+        for (old_ch, new_ch) in old.chars().zip(new.chars()) {
+            if old_ch != new_ch {
+                break;
+            }
+            prefix_len += old_ch.len_utf8();
+        }
+        Delta {
+            backspace_count: old[prefix_len..].chars().count(),
+            insert: InlineString::from(&new[prefix_len..])
+        }
+    }
+
+    /// Check if the delta doesn't change anything
+    pub fn is_empty(&self) -> bool {
+        self.backspace_count == 0 && self.insert.is_empty()
+    }
+}
+
+/// Apply the actions of a key to the content. If none of them can be
+/// applied, the key is appended instead. An action that fails but still
+/// changes the content, such as adding the same tone mark twice, stops
+/// the search.
+/// Return if an action has been applied or not
+pub(crate) fn apply_key(content: &mut String, key: char, actions: &[Action]) -> bool {
+    for action in actions {
+        let (success, new_content) = apply_action(content, action);
+        if let Cow::Owned(new_content) = new_content {
+            *content = new_content;
+            if !success {
+                break;
+            }
+        }
+        if success {
+            metrics::add(Counter::ActionsApplied, 1);
+            return true;
+        }
+    }
+    metrics::add(Counter::ActionsFailed, 1);
+    content.push(key);
+    false
+}
+
+/// Feed a key to the content. Keys that are not in the key map are
+/// appended as is, as are action keys once the word can't become a
+/// vietnamese syllable. When a letter is appended, the tone mark is moved
+/// to follow it.
+/// Return if an action has been applied or not
+pub(crate) fn push_key(content: &mut String, key: char, key_map: &KeyMap) -> bool {
+    match key_map.get(&key) {
+        Some(actions) if is_valid_prefix(content) => {
+            if apply_key(content, key, actions) {
+                return true;
+            }
+        }
+        _ => content.push(key)
+    }
+    if key.is_alphabetic() {
+        replace_tone(content);
+    }
+    false
+}
+
+/// Put the tone mark of the word back to the right place after the
+/// letters has changed
+fn replace_tone(content: &mut String) {
+    if extract_tone(content).is_none() {
+        return;
+    }
+    if let Some(mut syllable) = Syllable::parse(content) {
+        let before = syllable;
+        syllable.replace_tone_mark();
+        if syllable != before {
+            metrics::add(Counter::Allocations, 1);
+            *content = syllable.to_string();
+        }
+    }
+}
+
+/// Same as `apply_key` on a syllable.
+/// Return if an action has been applied or not, or `None` if the
+/// syllable is too full to take the key.
+pub(crate) fn apply_syllable_key(syllable: &mut Syllable, key: char, actions: &[Action]) -> Option<bool> {
+    for action in actions {
+        let before = *syllable;
+        if syllable.apply_action(action) {
+            metrics::add(Counter::ActionsApplied, 1);
+            return Some(true);
+        }
+        if *syllable != before {
+            break;
+        }
+    }
+    if !syllable.push(key) {
+        return None;
+    }
+    metrics::add(Counter::ActionsFailed, 1);
+    Some(false)
+}
+
+/// Same as `push_key` on a syllable.
+/// Return if an action has been applied or not, or `None` if the
+/// syllable is too full to take the key.
+pub(crate) fn push_syllable_key(syllable: &mut Syllable, key: char, key_map: &KeyMap) -> Option<bool> {
+    let before = syllable.len();
+    let applied = match key_map.get(&key) {
+        Some(actions) if syllable.is_valid_prefix() => apply_syllable_key(syllable, key, actions)?,
+        _ if syllable.push(key) => false,
+        _ => return None
+    };
+    if syllable.len() > before && key.is_alphabetic() {
+        syllable.replace_tone_mark();
+    }
+    Some(applied)
+}
+
+/// Most keys of a word the engine remembers to undo
+pub const MAX_HISTORY_LENGTH: usize = 32;
+
+/// What the word was before a key, kept to undo the key
+#[derive(Clone, Copy)]
+struct Step {
+    before: Snapshot,
+    /// The key only appended a letter, so deleting that letter brings
+    /// the word back to `before`
+    appended: bool
+}
+
+/// The steps of the keys typed, oldest first, in a ring buffer stored
+/// inline so recording a key never allocates and forgetting the oldest
+/// one when it is full doesn't shift the others
+#[derive(Clone, Copy)]
+struct History {
+    steps: [Step; MAX_HISTORY_LENGTH],
+    /// Index of the oldest step in `steps`
+    head: usize,
+    len: usize
+}
+
+impl History {
+    fn new() -> Self {
+        let step = Step { before: Snapshot::default(), appended: false };
+        History { steps: [step; MAX_HISTORY_LENGTH], head: 0, len: 0 }
+    }
+
+    fn clear(&mut self) {
+        self.head = 0;
+        self.len = 0;
+    }
+
+    /// Index in `steps` of the step at `index`, counting from the oldest
+    fn slot(&self, index: usize) -> usize {
+        (self.head + index) % MAX_HISTORY_LENGTH
+    }
+
+    /// Add a step, forgetting the oldest one if the history is full
+    fn push(&mut self, step: Step) {
+        if self.len == MAX_HISTORY_LENGTH {
+            self.head = self.slot(1);
+            self.len -= 1;
+        }
+        let slot = self.slot(self.len);
+        self.steps[slot] = step;
+        self.len += 1;
+    }
+
+    fn pop(&mut self) -> Option<Step> {
+        if self.len == 0 {
+            return None;
+        }
+        self.len -= 1;
+        Some(self.steps[self.slot(self.len)])
+    }
+
+    fn last(&self) -> Option<&Step> {
+        self.len.checked_sub(1).map(|index| &self.steps[self.slot(index)])
+    }
+
+    /// Index of the newest step matching `predicate`, counting from the
+    /// oldest
+    fn rposition<F: Fn(&Step) -> bool>(&self, predicate: F) -> Option<usize> {
+        (0..self.len).rev().find(|index| predicate(&self.steps[self.slot(*index)]))
+    }
+
+    fn get_mut(&mut self, index: usize) -> &mut Step {
+        let slot = self.slot(index);
+        &mut self.steps[slot]
+    }
+
+    /// Remove the step at `index`, moving the newer ones back by one
+    fn remove(&mut self, index: usize) -> Step {
+        let step = self.steps[self.slot(index)];
+        for index in index..self.len - 1 {
+            let next = self.steps[self.slot(index + 1)];
+            *self.get_mut(index) = next;
+        }
+        self.len -= 1;
+        step
+    }
+}
+
+fn set_tone(syllable: &mut Syllable, tone_mark: Option<ToneMark>) {
+    match tone_mark {
+        Some(tone_mark) => syllable.add_tone(&tone_mark),
+        None => syllable.remove_tone()
+    };
+}
+
+/// An incremental engine that holds the word being typed with an input
+/// method. Each key is applied to the current word instead of
+/// re-transforming the whole input, and the engine returns the edit the
+/// frontend has to send.
+///
+/// Keys are applied in the order they are typed. A tone mark typed in the
+/// middle of a word is moved to its right place as more letters come.
+/// With vni, when all letters are typed before the numbers, the word is
+/// the same as the output of `vni::transform_buffer`.
+///
+/// The state of the word before each key is kept, so undoing a key or
+/// deleting a letter that was just typed restores the previous word as is
+/// instead of transforming it again.
+///
+/// # Example
+/// ```
+/// use vi::engine::Engine;
+/// use vi::vni::VNI;
+///
+/// let mut engine = Engine::new(&VNI);
+/// for ch in "viet6".chars() {
+///     engine.push(ch);
+/// }
+/// let delta = engine.push('5');
+/// assert_eq!(delta.backspace_count, 2);
+/// assert_eq!(delta.insert, "ệt");
+/// assert_eq!(engine.commit(), "việt");
+/// ```
+pub struct Engine {
+    key_map: &'static KeyMap,
+    form: Form,
+    tone_style: ToneStyle,
+    /// The word as a syllable while it fits in one. Longer tokens are
+    /// only kept as text in `view`.
+    syllable: Option<Syllable>,
+    view: InlineString,
+    history: History
+}
+
+impl Engine {
+    pub fn new(method: &'static InputMethod) -> Self {
+        Engine::with_form(method, Form::Nfc)
+    }
+
+    /// Create an engine whose deltas and committed words are in the given
+    /// normalization form
+    ///
+    /// # Example
+    /// ```
+    /// use vi::engine::Engine;
+    /// use vi::normalize::Form;
+    /// use vi::vni::VNI;
+    ///
+    /// let mut engine = Engine::with_form(&VNI, Form::Nfd);
+    /// engine.push('a');
+    /// let delta = engine.push('1');
+    /// assert_eq!(delta.insert, "\u{301}");
+    /// ```
+    pub fn with_form(method: &'static InputMethod, form: Form) -> Self {
+        Engine {
+            key_map: method.keys,
+            form,
+            tone_style: ToneStyle::New,
+            syllable: Some(Syllable::new()),
+            view: InlineString::new(),
+            history: History::new()
+        }
+    }
+
+    /// Place tone marks in the given style, `ToneStyle::New` by default.
+    /// The word being typed follows the new style right away, without a
+    /// delta, so this is best called between words.
+    ///
+    /// # Example
+    /// ```
+    /// use vi::engine::Engine;
+    /// use vi::syllable::ToneStyle;
+    /// use vi::vni::VNI;
+    ///
+    /// let mut engine = Engine::new(&VNI);
+    /// engine.set_tone_style(ToneStyle::Old);
+    /// for ch in "hoa2".chars() {
+    ///     engine.push(ch);
+    /// }
+    /// assert_eq!(engine.commit(), "hòa");
+    /// ```
+    pub fn set_tone_style(&mut self, tone_style: ToneStyle) {
+        self.tone_style = tone_style;
+        self.history.clear();
+        if let Some(syllable) = &mut self.syllable {
+            syllable.set_tone_style(tone_style);
+            self.render();
+        }
+    }
+
+    /// Get the word being typed, always precomposed
+    pub fn view(&self) -> &str {
+        &self.view
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.view.is_empty()
+    }
+
+    /// Feed a key to the engine
+    pub fn push(&mut self, ch: char) -> Delta {
+        let old_view = self.view.clone();
+        if let Some(syllable) = &mut self.syllable {
+            let before = *syllable;
+            if push_syllable_key(syllable, ch, self.key_map).is_some() {
+                let appended = syllable.extends(&before);
+                self.history.push(Step { before: before.snapshot(), appended });
+                self.render();
+                return self.delta_from(&old_view);
+            }
+            *syllable = before;
+            self.syllable = None;
+        }
+        self.history.clear();
+        let mut content = String::from(mem::take(&mut self.view));
+        push_key(&mut content, ch, self.key_map);
+        self.view = content.into();
+        self.delta_from(&old_view)
+    }
+
+    /// Remove the last char of the word. When the last key typed that
+    /// char, the word goes back to what it was before the key.
+    pub fn backspace(&mut self) -> Delta {
+        let old_view = self.view.clone();
+        match (self.history.last(), &mut self.syllable) {
+            (Some(step), Some(syllable)) if step.appended => {
+                syllable.restore(&step.before);
+                self.history.pop();
+            }
+            _ => {
+                self.history.clear();
+                self.view.pop();
+                self.syllable = Syllable::parse(&self.view);
+                if let Some(syllable) = &mut self.syllable {
+                    syllable.set_tone_style(self.tone_style);
+                }
+            }
+        }
+        self.render();
+        self.delta_from(&old_view)
+    }
+
+    /// Undo the last key, whatever it did. Nothing changes once every key
+    /// of the word has been undone, or if the word has been edited in a
+    /// way that can't be undone.
+    ///
+    /// # Example
+    /// ```
+    /// use vi::engine::Engine;
+    /// use vi::telex::TELEX;
+    ///
+    /// let mut engine = Engine::new(&TELEX);
+    /// for ch in "tieengs".chars() {
+    ///     engine.push(ch);
+    /// }
+    /// engine.undo();
+    /// assert_eq!(engine.view(), "tiêng");
+    /// engine.undo();
+    /// assert_eq!(engine.view(), "tiên");
+    /// ```
+    pub fn undo(&mut self) -> Delta {
+        let old_view = self.view.clone();
+        // the history is cleared when the word leaves the syllable
+        if let (Some(step), Some(syllable)) = (self.history.pop(), &mut self.syllable) {
+            syllable.restore(&step.before);
+            self.render();
+        }
+        self.delta_from(&old_view)
+    }
+
+    /// Put the tone mark back to what it was before the last key that
+    /// changed it, keeping the letters typed since then. That key's step
+    /// is taken out of the history and the tone of the steps after it is
+    /// fixed up, which walks at most `MAX_HISTORY_LENGTH` steps once per
+    /// call rather than on every key.
+    ///
+    /// # Example
+    /// ```
+    /// use vi::engine::Engine;
+    /// use vi::vni::VNI;
+    ///
+    /// let mut engine = Engine::new(&VNI);
+    /// for ch in "to1i2".chars() {
+    ///     engine.push(ch);
+    /// }
+    /// assert_eq!(engine.view(), "tòi");
+    /// engine.undo_tone();
+    /// assert_eq!(engine.view(), "tói");
+    /// ```
+    pub fn undo_tone(&mut self) -> Delta {
+        let old_view = self.view.clone();
+        let syllable = match &mut self.syllable {
+            Some(syllable) => syllable,
+            None => return Delta::default()
+        };
+        // the keys after the last tone change kept the tone, so the key that
+        // changed it is the last one with a different tone before it
+        let current = syllable.tone_mark();
+        let found = self.history.rposition(|step| step.before.tone_mark() != current);
+        let index = match found {
+            Some(index) => index,
+            None => return Delta::default()
+        };
+        let tone_mark = self.history.remove(index).before.tone_mark();
+        set_tone(syllable, tone_mark);
+        // the word before the keys typed since then get the tone back as well
+        for index in index..self.history.len {
+            self.history.get_mut(index).before.set_tone_mark(tone_mark);
+        }
+        self.render();
+        self.delta_from(&old_view)
+    }
+
+    /// Finish the current word, return it and reset the engine
+    pub fn commit(&mut self) -> String {
+        let content = match self.form {
+            Form::Nfc => String::from(mem::take(&mut self.view)),
+            Form::Nfd => {
+                metrics::add(Counter::Allocations, 1);
+                let mut result = String::new();
+                to_nfd(&self.view, &mut result);
+                result
+            }
+        };
+        self.reset();
+        content
+    }
+
+    /// Write the word being typed in the output form, without committing
+    /// it or allocating.
+    pub fn write_word<W: fmt::Write>(&self, output: &mut W) -> fmt::Result {
+        match self.form {
+            Form::Nfc => output.write_str(&self.view),
+            Form::Nfd => write_nfd(&self.view, output)
+        }
+    }
+
+    /// Drop the word being typed
+    pub fn reset(&mut self) {
+        self.history.clear();
+        self.syllable = Some(Syllable::with_tone_style(self.tone_style));
+        self.view.clear();
+    }
+
+    /// Render the syllable into the view
+    fn render(&mut self) {
+        if let Some(syllable) = &self.syllable {
+            self.view.clear();
+            write!(self.view, "{}", syllable).expect("writing to an InlineString never fails");
+        }
+    }
+
+    /// Compute the delta from the previous view, in the output form
+    fn delta_from(&self, old_view: &str) -> Delta {
+        match self.form {
+            Form::Nfc => Delta::between(old_view, &self.view),
+            Form::Nfd => {
+                let (mut old, mut new) = (InlineString::new(), InlineString::new());
+                write_nfd(old_view, &mut old).expect("writing to an InlineString never fails");
+                write_nfd(&self.view, &mut new).expect("writing to an InlineString never fails");
+                Delta::between(&old, &new)
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::vni::{VNI, transform_buffer};
+
+    #[test]
+    fn engine_same_as_transform_buffer() {
+        let inputs = vec![
+            "vit1", "vt1", "hoang2", "hoang23", "23", "a11", "CHAO2",
+            "luat650", "chet6100", "vit500", "vo7", "vuon7", "che7", "chE6"
+        ];
+        for input in inputs {
+            let buffer: Vec<char> = input.chars().collect();
+            let mut engine = Engine::new(&VNI);
+            for ch in &buffer {
+                engine.push(*ch);
+            }
+            let (_, expected) = transform_buffer(&buffer);
+            assert_eq!(engine.commit(), expected);
+        }
+    }
+
+    #[test]
+    fn engine_push_letter() {
+        let mut engine = Engine::new(&VNI);
+        engine.push('v');
+        let delta = engine.push('o');
+        assert_eq!(delta, Delta { backspace_count: 0, insert: "o".into() });
+        assert_eq!(engine.view(), "vo");
+    }
+
+    #[test]
+    fn engine_move_tone_mark() {
+        let mut engine = Engine::new(&VNI);
+        for ch in "to2".chars() {
+            engine.push(ch);
+        }
+        assert_eq!(engine.view(), "tò");
+        let delta = engine.push('a');
+        assert_eq!(delta, Delta { backspace_count: 1, insert: "oà".into() });
+        assert_eq!(engine.view(), "toà");
+    }
+
+    #[test]
+    fn engine_backspace() {
+        let mut engine = Engine::new(&VNI);
+        for ch in "toan2".chars() {
+            engine.push(ch);
+        }
+        let delta = engine.backspace();
+        assert_eq!(delta, Delta { backspace_count: 1, insert: InlineString::new() });
+        assert_eq!(engine.view(), "toà");
+    }
+
+    #[test]
+    fn engine_backspace_after_append() {
+        let mut engine = Engine::new(&VNI);
+        for ch in "to2a".chars() {
+            engine.push(ch);
+        }
+        assert_eq!(engine.view(), "toà");
+        let delta = engine.backspace();
+        assert_eq!(delta, Delta { backspace_count: 2, insert: "ò".into() });
+        assert_eq!(engine.view(), "tò");
+    }
+
+    #[test]
+    fn engine_undo() {
+        let mut engine = Engine::new(&VNI);
+        for ch in "a11".chars() {
+            engine.push(ch);
+        }
+        assert_eq!(engine.view(), "a1");
+        engine.undo();
+        assert_eq!(engine.view(), "á");
+        engine.undo();
+        engine.undo();
+        assert_eq!(engine.view(), "");
+        assert_eq!(engine.undo(), Delta::default());
+    }
+
+    #[test]
+    fn engine_undo_tone() {
+        let mut engine = Engine::new(&crate::telex::TELEX);
+        for ch in "tofsan".chars() {
+            engine.push(ch);
+        }
+        assert_eq!(engine.view(), "toán");
+        engine.undo_tone();
+        assert_eq!(engine.view(), "toàn");
+        engine.undo_tone();
+        assert_eq!(engine.view(), "toan");
+        assert_eq!(engine.undo_tone(), Delta::default());
+    }
+
+    #[test]
+    fn engine_undo_full_history() {
+        let mut engine = Engine::new(&crate::telex::TELEX);
+        let keys: Vec<char> = "a".chars().chain("sfr".chars().cycle().take(40)).collect();
+        let mut views = Vec::new();
+        for ch in &keys {
+            engine.push(*ch);
+            views.push(engine.view().to_owned());
+        }
+        for view in views.iter().rev().skip(1).take(MAX_HISTORY_LENGTH) {
+            engine.undo();
+            assert_eq!(engine.view(), view);
+        }
+        assert_eq!(engine.undo(), Delta::default());
+    }
+
+    #[test]
+    fn history_is_compact() {
+        // a step keeps a snapshot of a few bytes, not the whole syllable
+        assert!(mem::size_of::<Step>() <= 12);
+        assert!(mem::size_of::<History>() <= 400);
+    }
+
+    #[test]
+    fn engine_nfd_delta() {
+        let mut engine = Engine::with_form(&VNI, Form::Nfd);
+        for ch in "viet6".chars() {
+            engine.push(ch);
+        }
+        let delta = engine.push('5');
+        assert_eq!(delta, Delta { backspace_count: 2, insert: "\u{323}\u{302}t".into() });
+        assert_eq!(engine.commit(), "vie\u{323}\u{302}t");
+    }
+
+    #[test]
+    fn engine_long_token() {
+        let mut engine = Engine::new(&VNI);
+        for ch in "supercalifragilistic".chars() {
+            engine.push(ch);
+        }
+        let delta = engine.push('1');
+        assert_eq!(delta, Delta { backspace_count: 0, insert: "1".into() });
+        engine.backspace();
+        assert_eq!(engine.commit(), "supercalifragilistic");
+    }
+
+    #[test]
+    fn engine_commit_reset() {
+        let mut engine = Engine::new(&VNI);
+        engine.push('a');
+        engine.push('1');
+        assert_eq!(engine.commit(), "á");
+        assert!(engine.is_empty());
+    }
+}
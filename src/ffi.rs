@@ -0,0 +1,369 @@
+use std::fmt;
+use std::os::raw::c_int;
+use std::slice;
+use std::str;
+use super::engine::{Delta, Engine};
+use super::method::InputMethod;
+use super::normalize::Form;
+use super::{telex, viqr, vni};
+
+pub const VI_OK: c_int = 0;
+/// A required pointer is null
+pub const VI_ERROR_NULL: c_int = -1;
+/// The key is not a unicode scalar value, or the UTF-8 key is not a
+/// single char
+pub const VI_ERROR_INVALID_KEY: c_int = -2;
+/// The caller buffer is too small, the required length has been written
+pub const VI_ERROR_BUFFER_TOO_SMALL: c_int = -3;
+
+pub const VI_METHOD_VNI: u32 = 0;
+pub const VI_METHOD_TELEX: u32 = 1;
+pub const VI_METHOD_VIQR: u32 = 2;
+
+pub const VI_FORM_NFC: u32 = 0;
+pub const VI_FORM_NFD: u32 = 1;
+
+/// The edit returned for each key event: delete `backspace_count` chars,
+/// then insert the first `insert_len` bytes of the caller buffer
+#[repr(C)]
+#[derive(Debug, Default, Clone, Copy, PartialEq)]
+pub struct ViDelta {
+    pub backspace_count: usize,
+    pub insert_len: usize
+}
+
+/// An engine handle for C frontends, see `include/vi.h`. Each key event
+/// returns the edit to apply on screen with its text copied into a buffer
+/// owned by the caller, so nothing allocated here crosses the boundary.
+/// The delta of the last key event is kept so that its text can be
+/// fetched again with a larger buffer.
+pub struct ViEngine {
+    engine: Engine,
+    last_delta: Delta
+}
+
+/// A `fmt::Write` over a caller buffer that keeps counting the length
+/// once the buffer is full
+struct BufferWriter<'a> {
+    buffer: &'a mut [u8],
+    len: usize
+}
+
+impl<'a> fmt::Write for BufferWriter<'a> {
+    fn write_str(&mut self, text: &str) -> fmt::Result {
+        let end = self.len + text.len();
+        if end <= self.buffer.len() {
+            self.buffer[self.len..end].copy_from_slice(text.as_bytes());
+        }
+        self.len = end;
+        Ok(())
+    }
+}
+
+impl<'a> BufferWriter<'a> {
+    /// Wrap a caller buffer, a null buffer is an empty one
+    unsafe fn new(buffer: *mut u8, capacity: usize) -> Self {
+        let buffer = if buffer.is_null() {
+            &mut []
+        } else {
+            slice::from_raw_parts_mut(buffer, capacity)
+        };
+        BufferWriter { buffer, len: 0 }
+    }
+
+    fn fits(&self) -> bool {
+        self.len <= self.buffer.len()
+    }
+}
+
+fn method_from_id(method: u32) -> Option<&'static InputMethod> {
+    match method {
+        VI_METHOD_VNI => Some(&vni::VNI),
+        VI_METHOD_TELEX => Some(&telex::TELEX),
+        VI_METHOD_VIQR => Some(&viqr::VIQR),
+        _ => None
+    }
+}
+
+fn form_from_id(form: u32) -> Option<Form> {
+    match form {
+        VI_FORM_NFC => Some(Form::Nfc),
+        VI_FORM_NFD => Some(Form::Nfd),
+        _ => None
+    }
+}
+
+/// Copy the text of a string into a caller buffer and write its length
+unsafe fn copy_text(text: &str, buffer: *mut u8, capacity: usize, len: *mut usize) -> c_int {
+    let mut writer = BufferWriter::new(buffer, capacity);
+    fmt::Write::write_str(&mut writer, text).expect("writing to a buffer never fails");
+    if !len.is_null() {
+        *len = writer.len;
+    }
+    if writer.fits() { VI_OK } else { VI_ERROR_BUFFER_TOO_SMALL }
+}
+
+/// Keep a delta as the last one and copy it out to the caller
+unsafe fn output_delta(
+    engine: &mut ViEngine,
+    delta: Delta,
+    output: *mut ViDelta,
+    buffer: *mut u8,
+    capacity: usize
+) -> c_int {
+    engine.last_delta = delta;
+    let mut insert_len = 0;
+    let status = copy_text(&engine.last_delta.insert, buffer, capacity, &mut insert_len);
+    if !output.is_null() {
+        *output = ViDelta { backspace_count: engine.last_delta.backspace_count, insert_len };
+    }
+    status
+}
+
+/// Create an engine for one of the `VI_METHOD_*` input methods, with its
+/// output in one of the `VI_FORM_*` forms. Return null if either is unknown.
+#[no_mangle]
+pub extern "C" fn vi_engine_new(method: u32, form: u32) -> *mut ViEngine {
+    match (method_from_id(method), form_from_id(form)) {
+        (Some(method), Some(form)) => Box::into_raw(Box::new(ViEngine {
+            engine: Engine::with_form(method, form),
+            last_delta: Delta::default()
+        })),
+        _ => std::ptr::null_mut()
+    }
+}
+
+/// Destroy an engine created by `vi_engine_new`. A null engine is ignored.
+///
+/// # Safety
+/// `engine` must come from `vi_engine_new` and must not be used afterwards.
+#[no_mangle]
+pub unsafe extern "C" fn vi_engine_free(engine: *mut ViEngine) {
+    if !engine.is_null() {
+        drop(Box::from_raw(engine));
+    }
+}
+
+/// Feed a key given as a UTF-32 code point
+///
+/// # Safety
+/// `engine` must be a live engine, `delta` must be null or writable and
+/// `buffer` must be null or valid for `capacity` bytes.
+#[no_mangle]
+pub unsafe extern "C" fn vi_engine_push_utf32(
+    engine: *mut ViEngine,
+    key: u32,
+    delta: *mut ViDelta,
+    buffer: *mut u8,
+    capacity: usize
+) -> c_int {
+    let engine = match engine.as_mut() {
+        Some(engine) => engine,
+        None => return VI_ERROR_NULL
+    };
+    match std::char::from_u32(key) {
+        Some(key) => {
+            let result = engine.engine.push(key);
+            output_delta(engine, result, delta, buffer, capacity)
+        }
+        None => VI_ERROR_INVALID_KEY
+    }
+}
+
+/// Feed a key given as the UTF-8 bytes of a single char
+///
+/// # Safety
+/// Same as `vi_engine_push_utf32`, and `key` must be valid for `key_len`
+/// bytes.
+#[no_mangle]
+pub unsafe extern "C" fn vi_engine_push_utf8(
+    engine: *mut ViEngine,
+    key: *const u8,
+    key_len: usize,
+    delta: *mut ViDelta,
+    buffer: *mut u8,
+    capacity: usize
+) -> c_int {
+    if engine.is_null() || key.is_null() {
+        return VI_ERROR_NULL;
+    }
+    let mut chars = match str::from_utf8(slice::from_raw_parts(key, key_len)) {
+        Ok(text) => text.chars(),
+        Err(_) => return VI_ERROR_INVALID_KEY
+    };
+    match (chars.next(), chars.next()) {
+        (Some(key), None) => vi_engine_push_utf32(engine, key as u32, delta, buffer, capacity),
+        _ => VI_ERROR_INVALID_KEY
+    }
+}
+
+/// Remove the last char of the word being typed
+///
+/// # Safety
+/// Same as `vi_engine_push_utf32`.
+#[no_mangle]
+pub unsafe extern "C" fn vi_engine_backspace(
+    engine: *mut ViEngine,
+    delta: *mut ViDelta,
+    buffer: *mut u8,
+    capacity: usize
+) -> c_int {
+    let engine = match engine.as_mut() {
+        Some(engine) => engine,
+        None => return VI_ERROR_NULL
+    };
+    let result = engine.engine.backspace();
+    output_delta(engine, result, delta, buffer, capacity)
+}
+
+/// Copy the text inserted by the last key event again, such as after
+/// `VI_ERROR_BUFFER_TOO_SMALL`
+///
+/// # Safety
+/// `engine` must be a live engine, `buffer` must be null or valid for
+/// `capacity` bytes and `len` must be null or writable.
+#[no_mangle]
+pub unsafe extern "C" fn vi_engine_last_insert(
+    engine: *const ViEngine,
+    buffer: *mut u8,
+    capacity: usize,
+    len: *mut usize
+) -> c_int {
+    match engine.as_ref() {
+        Some(engine) => copy_text(&engine.last_delta.insert, buffer, capacity, len),
+        None => VI_ERROR_NULL
+    }
+}
+
+/// Copy the word being typed, always precomposed
+///
+/// # Safety
+/// Same as `vi_engine_last_insert`.
+#[no_mangle]
+pub unsafe extern "C" fn vi_engine_view(
+    engine: *const ViEngine,
+    buffer: *mut u8,
+    capacity: usize,
+    len: *mut usize
+) -> c_int {
+    match engine.as_ref() {
+        Some(engine) => copy_text(engine.engine.view(), buffer, capacity, len),
+        None => VI_ERROR_NULL
+    }
+}
+
+/// Copy the word being typed in the output form and reset the engine.
+/// When the buffer is too small the word is kept, so the call can be made
+/// again with a buffer of the written length.
+///
+/// # Safety
+/// Same as `vi_engine_last_insert`.
+#[no_mangle]
+pub unsafe extern "C" fn vi_engine_commit(
+    engine: *mut ViEngine,
+    buffer: *mut u8,
+    capacity: usize,
+    len: *mut usize
+) -> c_int {
+    let engine = match engine.as_mut() {
+        Some(engine) => engine,
+        None => return VI_ERROR_NULL
+    };
+    let mut writer = BufferWriter::new(buffer, capacity);
+    engine.engine.write_word(&mut writer).expect("writing to a buffer never fails");
+    if !len.is_null() {
+        *len = writer.len;
+    }
+    if !writer.fits() {
+        return VI_ERROR_BUFFER_TOO_SMALL;
+    }
+    engine.engine.reset();
+    engine.last_delta = Delta::default();
+    VI_OK
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    unsafe fn push_str(engine: *mut ViEngine, keys: &str) -> (ViDelta, String) {
+        let mut buffer = [0; 32];
+        let mut delta = ViDelta::default();
+        for key in keys.chars() {
+            let status = vi_engine_push_utf32(engine, key as u32, &mut delta, buffer.as_mut_ptr(), buffer.len());
+            assert_eq!(status, VI_OK);
+        }
+        (delta, str::from_utf8(&buffer[..delta.insert_len]).unwrap().to_owned())
+    }
+
+    #[test]
+    fn push_and_commit() {
+        unsafe {
+            let engine = vi_engine_new(VI_METHOD_VNI, VI_FORM_NFC);
+            let (delta, insert) = push_str(engine, "viet65");
+            assert_eq!(delta.backspace_count, 2);
+            assert_eq!(insert, "ệt");
+
+            let mut buffer = [0; 16];
+            let mut len = 0;
+            assert_eq!(vi_engine_commit(engine, buffer.as_mut_ptr(), buffer.len(), &mut len), VI_OK);
+            assert_eq!(str::from_utf8(&buffer[..len]).unwrap(), "việt");
+            assert_eq!(vi_engine_view(engine, buffer.as_mut_ptr(), buffer.len(), &mut len), VI_OK);
+            assert_eq!(len, 0);
+            vi_engine_free(engine);
+        }
+    }
+
+    #[test]
+    fn push_utf8() {
+        unsafe {
+            let engine = vi_engine_new(VI_METHOD_TELEX, VI_FORM_NFC);
+            let mut buffer = [0; 16];
+            let mut delta = ViDelta::default();
+            for key in ["a", "s"].iter() {
+                vi_engine_push_utf8(engine, key.as_ptr(), key.len(), &mut delta, buffer.as_mut_ptr(), buffer.len());
+            }
+            assert_eq!(&buffer[..delta.insert_len], "á".as_bytes());
+            let keys = "ab";
+            let status = vi_engine_push_utf8(engine, keys.as_ptr(), keys.len(), &mut delta, buffer.as_mut_ptr(), buffer.len());
+            assert_eq!(status, VI_ERROR_INVALID_KEY);
+            vi_engine_free(engine);
+        }
+    }
+
+    #[test]
+    fn buffer_too_small() {
+        unsafe {
+            let engine = vi_engine_new(VI_METHOD_VNI, VI_FORM_NFD);
+            push_str(engine, "viet");
+            let mut delta = ViDelta::default();
+            let status = vi_engine_push_utf32(engine, '6' as u32, &mut delta, std::ptr::null_mut(), 0);
+            assert_eq!(status, VI_ERROR_BUFFER_TOO_SMALL);
+            assert_eq!(delta.insert_len, 3);
+
+            let mut buffer = [0; 3];
+            let mut len = 0;
+            assert_eq!(vi_engine_last_insert(engine, buffer.as_mut_ptr(), buffer.len(), &mut len), VI_OK);
+            assert_eq!(str::from_utf8(&buffer[..len]).unwrap(), "\u{302}t");
+            assert_eq!(vi_engine_commit(engine, buffer.as_mut_ptr(), buffer.len(), &mut len), VI_ERROR_BUFFER_TOO_SMALL);
+            assert_eq!(len, 6);
+            let mut buffer = [0; 6];
+            assert_eq!(vi_engine_commit(engine, buffer.as_mut_ptr(), buffer.len(), &mut len), VI_OK);
+            assert_eq!(str::from_utf8(&buffer[..len]).unwrap(), "vie\u{302}t");
+            vi_engine_free(engine);
+        }
+    }
+
+    #[test]
+    fn invalid_arguments() {
+        unsafe {
+            assert!(vi_engine_new(3, VI_FORM_NFC).is_null());
+            assert!(vi_engine_new(VI_METHOD_VNI, 2).is_null());
+            assert_eq!(vi_engine_backspace(std::ptr::null_mut(), std::ptr::null_mut(), std::ptr::null_mut(), 0), VI_ERROR_NULL);
+            let engine = vi_engine_new(VI_METHOD_VIQR, VI_FORM_NFC);
+            let status = vi_engine_push_utf32(engine, 0xd800, std::ptr::null_mut(), std::ptr::null_mut(), 0);
+            assert_eq!(status, VI_ERROR_INVALID_KEY);
+            vi_engine_free(engine);
+        }
+    }
+}
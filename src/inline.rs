@@ -0,0 +1,200 @@
+use std::fmt;
+use std::ops::Deref;
+use std::str;
+use super::metrics::{self, Counter};
+
+/// Number of bytes an `InlineString` holds before moving to the heap.
+/// A syllable of `MAX_SYLLABLE_LENGTH` letters always fits.
+pub const INLINE_CAPACITY: usize = 64;
+
+#[derive(Clone)]
+enum Repr {
+    Inline { len: u8, bytes: [u8; INLINE_CAPACITY] },
+    Heap(String)
+}
+
+/// A string stored inline while it is short, and on the heap once it
+/// outgrows `INLINE_CAPACITY`. Words being typed are short, so building
+/// them doesn't touch the allocator, while longer tokens still work.
+///
+/// # Example
+/// ```
+/// use vi::inline::InlineString;
+///
+/// let mut text = InlineString::new();
+/// text.push_str("việt");
+/// assert_eq!(text, "việt");
+/// assert!(text.is_inline());
+/// ```
+#[derive(Clone)]
+pub struct InlineString {
+    repr: Repr
+}
+
+impl InlineString {
+    pub fn new() -> Self {
+        InlineString { repr: Repr::Inline { len: 0, bytes: [0; INLINE_CAPACITY] } }
+    }
+
+    pub fn as_str(&self) -> &str {
+        match &self.repr {
+            // only whole UTF-8 strings are ever copied into the buffer
+            Repr::Inline { len, bytes } => str::from_utf8(&bytes[..*len as usize]).unwrap(),
+            Repr::Heap(string) => string
+        }
+    }
+
+    /// Check if the string is still stored inline
+    pub fn is_inline(&self) -> bool {
+        matches!(self.repr, Repr::Inline { .. })
+    }
+
+    pub fn push_str(&mut self, text: &str) {
+        match &mut self.repr {
+            Repr::Inline { len, bytes } => {
+                let start = *len as usize;
+                if start + text.len() <= INLINE_CAPACITY {
+                    bytes[start..start + text.len()].copy_from_slice(text.as_bytes());
+                    *len += text.len() as u8;
+                    return;
+                }
+                metrics::add(Counter::Allocations, 1);
+                let mut string = String::with_capacity(start + text.len());
+                string.push_str(str::from_utf8(&bytes[..start]).unwrap());
+                string.push_str(text);
+                self.repr = Repr::Heap(string);
+            }
+            Repr::Heap(string) => string.push_str(text)
+        }
+    }
+
+    pub fn push(&mut self, ch: char) {
+        self.push_str(ch.encode_utf8(&mut [0; 4]));
+    }
+
+    /// Remove the last char and return it
+    pub fn pop(&mut self) -> Option<char> {
+        let ch = self.as_str().chars().next_back()?;
+        match &mut self.repr {
+            Repr::Inline { len, .. } => *len -= ch.len_utf8() as u8,
+            Repr::Heap(string) => {
+                string.pop();
+            }
+        }
+        Some(ch)
+    }
+
+    /// Empty the string, keeping the heap buffer if there is one
+    pub fn clear(&mut self) {
+        match &mut self.repr {
+            Repr::Inline { len, .. } => *len = 0,
+            Repr::Heap(string) => string.clear()
+        }
+    }
+}
+
+impl Default for InlineString {
+    fn default() -> Self {
+        InlineString::new()
+    }
+}
+
+impl Deref for InlineString {
+    type Target = str;
+
+    fn deref(&self) -> &str {
+        self.as_str()
+    }
+}
+
+impl From<&str> for InlineString {
+    fn from(text: &str) -> Self {
+        let mut string = InlineString::new();
+        string.push_str(text);
+        string
+    }
+}
+
+impl From<String> for InlineString {
+    fn from(text: String) -> Self {
+        if text.len() <= INLINE_CAPACITY {
+            return InlineString::from(text.as_str());
+        }
+        InlineString { repr: Repr::Heap(text) }
+    }
+}
+
+impl From<InlineString> for String {
+    fn from(text: InlineString) -> Self {
+        match text.repr {
+            Repr::Inline { len: 0, .. } => String::new(),
+            Repr::Inline { .. } => {
+                metrics::add(Counter::Allocations, 1);
+                text.as_str().to_owned()
+            }
+            Repr::Heap(string) => string
+        }
+    }
+}
+
+impl fmt::Write for InlineString {
+    fn write_str(&mut self, text: &str) -> fmt::Result {
+        self.push_str(text);
+        Ok(())
+    }
+}
+
+impl fmt::Display for InlineString {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        f.write_str(self.as_str())
+    }
+}
+
+impl fmt::Debug for InlineString {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        fmt::Debug::fmt(self.as_str(), f)
+    }
+}
+
+impl PartialEq for InlineString {
+    fn eq(&self, other: &InlineString) -> bool {
+        self.as_str() == other.as_str()
+    }
+}
+
+impl PartialEq<str> for InlineString {
+    fn eq(&self, other: &str) -> bool {
+        self.as_str() == other
+    }
+}
+
+impl PartialEq<&str> for InlineString {
+    fn eq(&self, other: &&str) -> bool {
+        self.as_str() == *other
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn push_and_pop() {
+        let mut text = InlineString::from("việ");
+        text.push('t');
+        assert_eq!(text, "việt");
+        assert_eq!(text.pop(), Some('t'));
+        assert_eq!(text.pop(), Some('ệ'));
+        assert_eq!(text, "vi");
+    }
+
+    #[test]
+    fn move_to_heap() {
+        let long = "ệ".repeat(INLINE_CAPACITY);
+        let mut text = InlineString::from("ab");
+        text.push_str(&long);
+        assert!(!text.is_inline());
+        assert_eq!(text.as_str(), format!("ab{}", long));
+        assert_eq!(String::from(text), format!("ab{}", long));
+    }
+}
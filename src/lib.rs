@@ -1,4 +1,29 @@
 pub mod util;
+pub mod metrics;
+pub mod inline;
 pub mod maps;
+pub mod decomposition;
+pub mod normalize;
+pub mod charset;
 pub mod processor;
+pub mod syllable;
+#[cfg(feature = "placement-table")]
+pub mod placement;
+pub mod tokenizer;
+pub mod validation;
+pub mod engine;
+#[cfg(feature = "ffi")]
+pub mod ffi;
+pub mod method;
+pub mod cache;
+pub mod pool;
+#[cfg(feature = "rayon")]
+pub mod parallel;
+pub mod stream;
+#[cfg(feature = "tokio")]
+pub mod async_stream;
+#[cfg(feature = "wasm")]
+pub mod wasm;
+pub mod telex;
 pub mod vni;
+pub mod viqr;
@@ -13,19 +13,6 @@ pub static ACCUTE_MAP: Map<char, char> = phf_map! {
     'u' => 'ú',
     'ư' => 'ứ',
     'y' => 'ý',
-    // uppercase
-    'A' => 'Á',
-    'Â' => 'Ấ',
-    'Ă' => 'Ắ',
-    'E' => 'É',
-    'Ê' => 'Ế',
-    'I' => 'Í',
-    'O' => 'Ó',
-    'Ô' => 'Ố',
-    'Ơ' => 'Ớ',
-    'U' => 'Ú',
-    'Ư' => 'Ứ',
-    'Y' => 'Ý',
 };
 
 pub static GRAVE_MAP: Map<char, char> = phf_map! {
@@ -41,19 +28,6 @@ pub static GRAVE_MAP: Map<char, char> = phf_map! {
     'u' => 'ù',
     'ư' => 'ừ',
     'y' => 'ỳ',
-    // uppercase
-    'A' => 'À',
-    'Â' => 'Ầ',
-    'Ă' => 'Ằ',
-    'E' => 'È',
-    'Ê' => 'Ề',
-    'I' => 'Ì',
-    'O' => 'Ò',
-    'Ô' => 'Ồ',
-    'Ơ' => 'Ờ',
-    'U' => 'Ù',
-    'Ư' => 'Ừ',
-    'Y' => 'Ỳ',
 };
 
 pub static HOOK_ABOVE_MAP: Map<char, char> = phf_map! {
@@ -69,19 +43,6 @@ pub static HOOK_ABOVE_MAP: Map<char, char> = phf_map! {
     'u' => 'ủ',
     'ư' => 'ử',
     'y' => 'ỷ',
-    // uppercase
-    'A' => 'Ả',
-    'Ă' => 'Ẳ',
-    'Â' => 'Ẩ',
-    'E' => 'Ẻ',
-    'Ê' => 'Ể',
-    'O' => 'Ỏ',
-    'Ô' => 'Ổ',
-    'Ơ' => 'Ở',
-    'I' => 'Ỉ',
-    'U' => 'Ủ',
-    'Ư' => 'Ử',
-    'Y' => 'Ỷ',
 };
 
 pub static TILDE_MAP: Map<char, char> = phf_map! {
@@ -97,19 +58,6 @@ pub static TILDE_MAP: Map<char, char> = phf_map! {
     'u' => 'ũ',
     'ư' => 'ữ',
     'y' => 'ỹ',
-    // uppercase
-    'A' => 'Ã',
-    'Ă' => 'Ẵ',
-    'Â' => 'Ẫ',
-    'E' => 'Ẽ',
-    'Ê' => 'Ễ',
-    'O' => 'Õ',
-    'Ô' => 'Ỗ',
-    'Ơ' => 'Ỡ',
-    'I' => 'Ĩ',
-    'U' => 'Ũ',
-    'Ư' => 'Ữ',
-    'Y' => 'Ỹ', 
 };
 
 pub static DOT_MAP: Map<char, char> = phf_map! {
@@ -125,43 +73,23 @@ pub static DOT_MAP: Map<char, char> = phf_map! {
     'u' => 'ụ',
     'ư' => 'ự',
     'y' => 'ỵ',
-    // uppercase
-    'A' => 'Ạ',
-    'Ă' => 'Ặ',
-    'Â' => 'Ậ',
-    'E' => 'Ẹ',
-    'Ê' => 'Ệ',
-    'O' => 'Ọ',
-    'Ô' => 'Ộ',
-    'Ơ' => 'Ợ',
-    'I' => 'Ị',
-    'U' => 'Ụ',
-    'Ư' => 'Ự',
-    'Y' => 'Ỵ',
-};      
+};
 
 pub static CIRCUMFLEX_MAP: Map<char, char> = phf_map! {
     'a' => 'â',
     'e' => 'ê',
     'o' => 'ô',
-    'A' => 'Â',
-    'E' => 'Ê',
-    'O' => 'Ô',
 };
 
 pub static DYET_MAP: Map<char, char> = phf_map! {
     'd' => 'đ',
-    'D' => 'Đ',
 };
 
 pub static HORN_MAP: Map<char, char> = phf_map! {
     'u' => 'ư',
     'o' => 'ơ',
-    'U' => 'Ư',
-    'O' => 'Ơ'
 };
 
 pub static BREVE_MAP: Map<char, char> = phf_map! {
     'a' => 'ă',
-    'A' => 'Ă',
 };
@@ -0,0 +1,516 @@
+use std::fmt::{self, Write};
+use std::sync::OnceLock;
+use super::engine::{KeyMap, apply_key, push_key, apply_syllable_key, push_syllable_key};
+use super::decomposition::decompose;
+use super::metrics::{self, Counter};
+use super::processor::{Action, ToneMark, LetterModification};
+use super::syllable::Syllable;
+use super::util::{ascii_prefix_len_outside, to_lowercase};
+use super::validation::is_valid_prefix;
+
+/// The order in which the keys of a word are applied
+#[derive(Debug, PartialEq, Clone, Copy)]
+pub enum KeyOrder {
+    /// All letters are typed first, then the action keys are applied in
+    /// order. Used when action keys can't be letters, such as vni numbers.
+    LettersFirst,
+    /// Keys are applied in the order they are typed. A key that can't be
+    /// applied is typed as is.
+    Typed
+}
+
+/// Longest word of a text that gets transformed, in bytes. Longer runs of
+/// word chars, such as hashes or base64 in logs, can't be vietnamese and
+/// are copied as is, so a stream never has to hold more of a word.
+pub const MAX_WORD_LENGTH: usize = 256;
+
+/// The bytes of a text that may trigger an action: the ASCII keys of an
+/// input method, and every non-ASCII byte since it may belong to a letter
+/// with marks
+struct Triggers {
+    keys: u128,
+    /// The range of the ASCII keys, skipped a word at a time
+    low: u8,
+    high: u8
+}
+
+impl Triggers {
+    fn new(keys: &KeyMap) -> Self {
+        let mut triggers = Triggers { keys: 0, low: 0x7f, high: 0 };
+        for key in keys.keys().filter(|key| key.is_ascii()) {
+            let byte = *key as u8;
+            triggers.keys |= 1 << byte;
+            triggers.low = triggers.low.min(byte);
+            triggers.high = triggers.high.max(byte);
+        }
+        triggers
+    }
+
+    fn contains(&self, byte: u8) -> bool {
+        !byte.is_ascii() || self.keys >> byte & 1 == 1
+    }
+
+    /// Position of the first trigger in `bytes`, or the length of `bytes`
+    /// if there is none
+    fn find(&self, bytes: &[u8]) -> usize {
+        let mut index = 0;
+        loop {
+            index += ascii_prefix_len_outside(&bytes[index..], self.low, self.high);
+            match bytes.get(index) {
+                Some(byte) if !self.contains(*byte) => index += 1,
+                _ => return index
+            }
+        }
+    }
+}
+
+/// An input method described as data: the table of keys mapped to the
+/// actions they trigger and the order they are applied in. The key map is
+/// a `phf` map built at compile time, so a custom layout is a static away.
+///
+/// # Example
+/// ```
+/// use phf::phf_map;
+/// use vi::engine::KeyMap;
+/// use vi::method::{InputMethod, KeyOrder};
+/// use vi::processor::{Action, ToneMark};
+///
+/// static MY_KEYS: KeyMap = phf_map! {
+///     '/' => &[Action::AddTone(ToneMark::Acute)],
+///     '\\' => &[Action::AddTone(ToneMark::Grave)],
+/// };
+/// static MY_METHOD: InputMethod = InputMethod::new(&MY_KEYS, KeyOrder::Typed);
+///
+/// let mut result = String::new();
+/// MY_METHOD.transform_str("to/i", &mut result);
+/// assert_eq!(result, "tói");
+/// ```
+pub struct InputMethod {
+    pub keys: &'static KeyMap,
+    pub order: KeyOrder,
+    /// Keys that also end sentences, such as `.` in viqr. In a text, one
+    /// of them ending a word is punctuation rather than a key.
+    pub sentence_marks: &'static [char],
+    /// The bytes of `keys` that may trigger an action, computed on the
+    /// first text transformed
+    triggers: OnceLock<Triggers>
+}
+
+impl InputMethod {
+    pub const fn new(keys: &'static KeyMap, order: KeyOrder) -> Self {
+        InputMethod { keys, order, sentence_marks: &[], triggers: OnceLock::new() }
+    }
+
+    pub const fn with_sentence_marks(mut self, sentence_marks: &'static [char]) -> Self {
+        self.sentence_marks = sentence_marks;
+        self
+    }
+
+    /// Transform input buffer to vietnamese string output along with
+    /// a bool indicating if an action has been triggered.
+    pub fn transform_buffer(&self, buffer: &[char]) -> (bool, String) {
+        metrics::add(Counter::Allocations, 1);
+        let mut content = String::new();
+        let has_action = self.transform_buffer_into(buffer, &mut content);
+        (has_action, content)
+    }
+
+    /// Same as `transform_buffer` but append the output to `output`.
+    /// Words that fit in a syllable are transformed without allocating.
+    /// Return if an action has been triggered.
+    pub fn transform_buffer_into(&self, buffer: &[char], output: &mut String) -> bool {
+        metrics::time_transform(|| {
+            if let Some((has_action, syllable)) = self.transform_syllable(buffer.iter().copied()) {
+                write!(output, "{}", syllable).expect("writing to a String never fails");
+                return has_action;
+            }
+            let (has_action, content) = self.transform_fallback(buffer);
+            output.push_str(&content);
+            has_action
+        })
+    }
+
+    /// Same as `transform_buffer` but always transform with the string
+    /// processor instead of the inline syllable, as words too long for a
+    /// syllable are. Slower, kept public to compare both paths.
+    ///
+    /// # Example
+    /// ```
+    /// use vi::vni::VNI;
+    ///
+    /// let keys: Vec<char> = "viet65".chars().collect();
+    /// assert_eq!(VNI.transform_buffer_reference(&keys), VNI.transform_buffer(&keys));
+    /// ```
+    pub fn transform_buffer_reference(&self, buffer: &[char]) -> (bool, String) {
+        match self.order {
+            KeyOrder::LettersFirst => self.transform_letters_first(buffer),
+            KeyOrder::Typed => self.transform_typed(buffer)
+        }
+    }
+
+    fn transform_letters_first(&self, buffer: &[char]) -> (bool, String) {
+        let mut content = String::new();
+        let mut actions = Vec::new();
+        for ch in buffer {
+            match self.keys.get(ch) {
+                Some(key_actions) => actions.push((*ch, key_actions)),
+                None => content.push(*ch)
+            }
+        }
+        metrics::add(Counter::Allocations, !content.is_empty() as u64 + !actions.is_empty() as u64);
+
+        if !is_valid_prefix(&content) {
+            // not a vietnamese word, type the action keys as is
+            return (false, buffer.iter().collect());
+        }
+        let has_action = !content.is_empty() && !actions.is_empty();
+        for (key, key_actions) in actions {
+            apply_key(&mut content, key, key_actions);
+        }
+        (has_action, content)
+    }
+
+    fn transform_typed(&self, buffer: &[char]) -> (bool, String) {
+        metrics::add(Counter::Allocations, 1);
+        let mut content = String::new();
+        let mut has_action = false;
+        for ch in buffer {
+            if push_key(&mut content, *ch, self.keys) {
+                has_action = true;
+            }
+        }
+        (has_action, content)
+    }
+
+    /// Transform the keys of a single word the same way `transform_buffer`
+    /// does, without leaving the inline syllable storage.
+    /// Return `None` if the result doesn't fit in a syllable.
+    fn transform_syllable<I>(&self, keys: I) -> Option<(bool, Syllable)>
+    where
+        I: Iterator<Item = char> + Clone
+    {
+        let mut syllable = Syllable::new();
+        let mut has_action = false;
+        match self.order {
+            KeyOrder::LettersFirst => {
+                for ch in keys.clone().filter(|ch| !self.keys.contains_key(ch)) {
+                    if !syllable.push(ch) {
+                        return None;
+                    }
+                }
+                if !syllable.is_valid_prefix() {
+                    return self.transform_raw(keys);
+                }
+                let has_letters = !syllable.is_empty();
+                for ch in keys {
+                    if let Some(actions) = self.keys.get(&ch) {
+                        has_action = has_letters;
+                        apply_syllable_key(&mut syllable, ch, actions)?;
+                    }
+                }
+            }
+            KeyOrder::Typed => {
+                for ch in keys {
+                    has_action |= push_syllable_key(&mut syllable, ch, self.keys)?;
+                }
+            }
+        }
+        Some((has_action, syllable))
+    }
+
+    /// Type every key of a word as is
+    fn transform_raw<I: Iterator<Item = char>>(&self, keys: I) -> Option<(bool, Syllable)> {
+        let mut syllable = Syllable::new();
+        for ch in keys {
+            if !syllable.push(ch) {
+                return None;
+            }
+        }
+        Some((false, syllable))
+    }
+
+    fn transform_fallback(&self, buffer: &[char]) -> (bool, String) {
+        metrics::add(Counter::HeapFallbacks, 1);
+        self.transform_buffer_reference(buffer)
+    }
+
+    fn transform_word<W: fmt::Write>(&self, keys: &str, output: &mut W) -> fmt::Result {
+        metrics::time_transform(|| {
+            if let Some((_, syllable)) = self.transform_syllable(keys.chars()) {
+                return write!(output, "{}", syllable);
+            }
+            metrics::add(Counter::Allocations, 1);
+            let buffer: Vec<char> = keys.chars().collect();
+            let (_, content) = self.transform_fallback(&buffer);
+            output.write_str(&content)
+        })
+    }
+
+    /// Same as `transform_buffer_into` with the keys of a word as a str
+    pub(crate) fn transform_keys_into(&self, keys: &str, output: &mut String) -> bool {
+        metrics::time_transform(|| {
+            if let Some((has_action, syllable)) = self.transform_syllable(keys.chars()) {
+                write!(output, "{}", syllable).expect("writing to a String never fails");
+                return has_action;
+            }
+            metrics::add(Counter::Allocations, 1);
+            let buffer: Vec<char> = keys.chars().collect();
+            let (has_action, content) = self.transform_fallback(&buffer);
+            output.push_str(&content);
+            has_action
+        })
+    }
+
+    /// Check if a char is part of a word: a letter, a number or a key of
+    /// the input method
+    pub fn is_word_char(&self, ch: char) -> bool {
+        ch.is_alphanumeric() || self.keys.contains_key(&ch)
+    }
+
+    /// Transform a whole text and write the result to `output`. Words are
+    /// runs of letters, numbers and keys of the input method, everything
+    /// else such as spaces and punctuation is copied as is, along with a
+    /// sentence mark ending a word and words longer than `MAX_WORD_LENGTH`.
+    pub fn transform_into<W: fmt::Write>(&self, input: &str, output: &mut W) -> fmt::Result {
+        self.transform_words(input, output, |word, output| self.transform_word(word, output))
+    }
+
+    /// Split a text into words and write each of them transformed by
+    /// `transform_word` to `output`. Everything else is copied as is.
+    ///
+    /// ASCII words without any key are left as they are, so the runs of
+    /// text before the word holding the next byte that may trigger an
+    /// action are copied without being split.
+    pub(crate) fn transform_words<W, F>(&self, input: &str, output: &mut W, mut transform_word: F) -> fmt::Result
+    where
+        W: fmt::Write,
+        F: FnMut(&str, &mut W) -> fmt::Result
+    {
+        let triggers = self.triggers.get_or_init(|| Triggers::new(self.keys));
+        let bytes = input.as_bytes();
+        let mut index = 0;
+        while index < input.len() {
+            let trigger = index + triggers.find(&bytes[index..]);
+            if trigger == input.len() {
+                return output.write_str(&input[index..]);
+            }
+            // the bytes before the trigger are ASCII
+            let word_start = bytes[index..trigger]
+                .iter()
+                .rposition(|byte| !self.is_word_char(*byte as char))
+                .map_or(index, |position| index + position + 1);
+            let word_end = input[trigger..]
+                .char_indices()
+                .find(|(position, ch)| *position > 0 && !self.is_word_char(*ch))
+                .map_or(input.len(), |(position, _)| trigger + position);
+            output.write_str(&input[index..word_start])?;
+            self.split_words(&input[word_start..word_end], output, &mut transform_word)?;
+            index = word_end;
+        }
+        Ok(())
+    }
+
+    fn split_words<W, F>(&self, input: &str, output: &mut W, transform_word: &mut F) -> fmt::Result
+    where
+        W: fmt::Write,
+        F: FnMut(&str, &mut W) -> fmt::Result
+    {
+        let mut word_start: Option<usize> = None;
+        for (index, ch) in input.char_indices() {
+            if self.is_word_char(ch) {
+                if word_start.is_none() {
+                    word_start = Some(index);
+                }
+                continue;
+            }
+            if let Some(start) = word_start.take() {
+                self.transform_sentence_word(&input[start..index], output, transform_word)?;
+            }
+            output.write_char(ch)?;
+        }
+        if let Some(start) = word_start {
+            self.transform_sentence_word(&input[start..], output, transform_word)?;
+        }
+        Ok(())
+    }
+
+    /// Transform a word of a text, copying the sentence mark ending it as is
+    fn transform_sentence_word<W, F>(&self, word: &str, output: &mut W, transform_word: &mut F) -> fmt::Result
+    where
+        W: fmt::Write,
+        F: FnMut(&str, &mut W) -> fmt::Result
+    {
+        if word.len() > MAX_WORD_LENGTH {
+            return output.write_str(word);
+        }
+        let mark = match word.chars().next_back() {
+            Some(ch) if self.sentence_marks.contains(&ch) => ch,
+            _ => return transform_word(word, output)
+        };
+        let letters = &word[..word.len() - mark.len_utf8()];
+        if !letters.is_empty() {
+            transform_word(letters, output)?;
+        }
+        output.write_char(mark)
+    }
+
+    /// Transform a whole text and append the result to `output`
+    pub fn transform_str(&self, input: &str, output: &mut String) {
+        self.transform_into(input, output).expect("writing to a String never fails")
+    }
+
+    /// Find the key triggering a matching action. Keys in the same case as
+    /// the letter are preferred, then the smallest one so the choice
+    /// doesn't depend on the order of the key map.
+    fn find_key<F: Fn(&Action) -> bool>(&self, uppercase: bool, matches: F) -> Option<char> {
+        self.keys
+            .entries()
+            .filter(|(_, actions)| actions.iter().any(|action| matches(action)))
+            .map(|(key, _)| *key)
+            .min_by_key(|key| (key.is_uppercase() != uppercase, *key))
+    }
+
+    fn modification_key(&self, base: char, modification: LetterModification, uppercase: bool) -> Option<char> {
+        let (family, _) = to_lowercase(base);
+        self.find_key(uppercase, |action| match action {
+            Action::ModifyLetter(key_modification) => *key_modification == modification,
+            Action::ModifyLetterOnCharacterFamily(key_modification, key_family) => {
+                *key_modification == modification && *key_family == family
+            }
+            _ => false
+        })
+    }
+
+    fn tone_key(&self, tone_mark: ToneMark, uppercase: bool) -> Option<char> {
+        self.find_key(uppercase, |action| *action == Action::AddTone(tone_mark))
+    }
+
+    /// Turn vietnamese text back into the keys typed with the input method
+    /// and append them to `output`, the reverse of `transform_str`. Each
+    /// letter is split into its base letter, modification and tone mark.
+    /// Modification keys follow their letter and the tone key follows the
+    /// vowel, or all of them come after the word's letters when letters are
+    /// typed first. A letter whose marks have no key is copied as is.
+    pub fn decompose_to_keys(&self, input: &str, output: &mut String) {
+        let mut pending = PendingKeys::default();
+        for ch in input.chars() {
+            if !ch.is_alphabetic() {
+                pending.flush(output);
+                output.push(ch);
+                continue;
+            }
+            let (base, modification, tone_mark) = decompose(ch);
+            let uppercase = base.is_uppercase();
+            let modification_key = match modification {
+                Some(modification) => self.modification_key(base, modification, uppercase),
+                None => None
+            };
+            let tone_key = match tone_mark {
+                Some(tone_mark) => self.tone_key(tone_mark, uppercase),
+                None => None
+            };
+            if modification_key.is_none() != modification.is_none() || tone_key.is_none() != tone_mark.is_none() {
+                output.push(ch);
+                continue;
+            }
+            if self.order == KeyOrder::Typed && !"aeiouy".contains(to_lowercase(base).0) {
+                // the tone key is typed right after the vowel
+                pending.flush(output);
+            }
+            output.push(base);
+            if let Some(key) = modification_key {
+                match self.order {
+                    KeyOrder::Typed => output.push(key),
+                    KeyOrder::LettersFirst => pending.push(key)
+                }
+            }
+            if let Some(key) = tone_key {
+                pending.tone_key = Some(key);
+            }
+        }
+        pending.flush(output);
+    }
+}
+
+/// Keys held until the end of a word while decomposing it: modification
+/// keys typed after the letters, each of them once, then the tone key
+#[derive(Default)]
+struct PendingKeys {
+    modification_keys: [char; 4],
+    len: usize,
+    tone_key: Option<char>
+}
+
+impl PendingKeys {
+    fn push(&mut self, key: char) {
+        if !self.modification_keys[..self.len].contains(&key) && self.len < self.modification_keys.len() {
+            self.modification_keys[self.len] = key;
+            self.len += 1;
+        }
+    }
+
+    fn flush(&mut self, output: &mut String) {
+        output.extend(&self.modification_keys[..self.len]);
+        output.extend(self.tone_key.take());
+        self.len = 0;
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use phf::phf_map;
+
+    static CUSTOM_KEYS: KeyMap = phf_map! {
+        '1' => &[Action::AddTone(ToneMark::Acute)],
+        '^' => &[Action::ModifyLetter(LetterModification::Circumflex)],
+    };
+
+    #[test]
+    fn custom_method_letters_first() {
+        let method = InputMethod::new(&CUSTOM_KEYS, KeyOrder::LettersFirst);
+        assert_eq!(method.transform_buffer(&['t', '^', '1', 'o', 'i']), (true, "tối".to_owned()));
+    }
+
+    #[test]
+    fn custom_method_typed() {
+        let method = InputMethod::new(&CUSTOM_KEYS, KeyOrder::Typed);
+        assert_eq!(method.transform_buffer(&['t', '^', 'o']), (false, "t^o".to_owned()));
+    }
+
+    #[test]
+    fn keys_are_word_chars() {
+        let method = InputMethod::new(&CUSTOM_KEYS, KeyOrder::Typed);
+        let mut result = String::new();
+        method.transform_str("to^1i, ban.", &mut result);
+        assert_eq!(result, "tối, ban.");
+    }
+
+    #[test]
+    fn find_triggers() {
+        let triggers = Triggers::new(&CUSTOM_KEYS);
+        assert_eq!(triggers.find(b"xin chao ban, hom nay"), 21);
+        assert_eq!(triggers.find(b"xin chao1"), 8);
+        assert_eq!(triggers.find("xin chào".as_bytes()), 6);
+        assert_eq!(triggers.find(b"a:b;c<d=e>f@g[h]i_j^"), 19);
+    }
+
+    #[test]
+    fn copy_untouched_runs() {
+        let method = InputMethod::new(&CUSTOM_KEYS, KeyOrder::Typed);
+        assert!(method.triggers.get().is_none());
+        let mut result = String::new();
+        method.transform_str("hello world, to^1i la ngu7o72i Vie^t. ", &mut result);
+        assert_eq!(result, "hello world, tối la ngu7o72i Viêt. ");
+        assert!(method.triggers.get().is_some());
+    }
+
+    #[test]
+    fn skip_non_vietnamese_words() {
+        let method = InputMethod::new(&CUSTOM_KEYS, KeyOrder::LettersFirst);
+        assert_eq!(method.transform_buffer(&['h', 'e', 'l', 'l', 'o', '1']), (false, "hello1".to_owned()));
+        let mut result = String::new();
+        method.transform_str("print1 to^1i", &mut result);
+        assert_eq!(result, "print1 tối");
+    }
+}
@@ -0,0 +1,154 @@
+#[cfg(feature = "metrics")]
+use std::sync::atomic::{AtomicU64, Ordering};
+#[cfg(feature = "metrics")]
+use std::time::Instant;
+
+/// The counters kept by the `metrics` feature. Without the feature,
+/// recording a counter is an empty inline function.
+#[derive(Debug, Clone, Copy, PartialEq)]
+#[cfg_attr(not(feature = "metrics"), allow(dead_code))]
+pub(crate) enum Counter {
+    Transforms,
+    TransformNanos,
+    ActionsApplied,
+    ActionsFailed,
+    CacheHits,
+    CacheMisses,
+    HeapFallbacks,
+    Allocations
+}
+
+#[cfg(feature = "metrics")]
+const COUNTER_COUNT: usize = 8;
+
+#[cfg(feature = "metrics")]
+#[allow(clippy::declare_interior_mutable_const)]
+const ZERO: AtomicU64 = AtomicU64::new(0);
+
+#[cfg(feature = "metrics")]
+static COUNTERS: [AtomicU64; COUNTER_COUNT] = [ZERO; COUNTER_COUNT];
+
+/// Add to a counter
+#[inline(always)]
+pub(crate) fn add(counter: Counter, value: u64) {
+    #[cfg(feature = "metrics")]
+    COUNTERS[counter as usize].fetch_add(value, Ordering::Relaxed);
+    #[cfg(not(feature = "metrics"))]
+    let _ = (counter, value);
+}
+
+/// Run a word transform, counting it along with the time it took
+#[inline(always)]
+pub(crate) fn time_transform<T, F: FnOnce() -> T>(transform: F) -> T {
+    #[cfg(feature = "metrics")]
+    {
+        let start = Instant::now();
+        let result = transform();
+        add(Counter::Transforms, 1);
+        add(Counter::TransformNanos, start.elapsed().as_nanos() as u64);
+        result
+    }
+    #[cfg(not(feature = "metrics"))]
+    transform()
+}
+
+/// The counters at some point in time. Counters are updated with relaxed
+/// atomics, so a snapshot taken while other threads are transforming may
+/// mix counts from slightly different moments.
+#[cfg(feature = "metrics")]
+#[derive(Debug, Default, Clone, Copy, PartialEq)]
+pub struct Snapshot {
+    /// Words transformed, through `transform_buffer`, `transform_str` and
+    /// the cache misses
+    pub transforms: u64,
+    /// Total time spent in word transforms
+    pub transform_nanos: u64,
+    /// Action keys that have been applied
+    pub actions_applied: u64,
+    /// Action keys that couldn't be applied and were typed as is
+    pub actions_failed: u64,
+    pub cache_hits: u64,
+    pub cache_misses: u64,
+    /// Words too long for the inline syllable storage, which were
+    /// transformed on the heap
+    pub heap_fallbacks: u64,
+    /// Heap buffers created along the way: the words and keys of the
+    /// string processor and the cache, the engine's long tokens, words
+    /// moving out of inline storage and the words returned by
+    /// `transform_buffer` and `Engine::commit`. Regrowing a buffer and
+    /// writing to one the caller passed in are not counted.
+    pub allocations: u64
+}
+
+#[cfg(feature = "metrics")]
+impl Snapshot {
+    /// Average time of a word transform in nanoseconds, 0 when nothing
+    /// has been transformed
+    pub fn average_transform_nanos(&self) -> f64 {
+        if self.transforms == 0 {
+            return 0.0;
+        }
+        self.transform_nanos as f64 / self.transforms as f64
+    }
+}
+
+/// Read every counter
+///
+/// # Example
+/// ```
+/// use vi::metrics;
+///
+/// let before = metrics::snapshot();
+/// let (_, result) = vi::vni::transform_buffer(&['a', '1']);
+/// assert_eq!(result, "á");
+/// assert!(metrics::snapshot().actions_applied > before.actions_applied);
+/// ```
+#[cfg(feature = "metrics")]
+pub fn snapshot() -> Snapshot {
+    let get = |counter: Counter| COUNTERS[counter as usize].load(Ordering::Relaxed);
+    Snapshot {
+        transforms: get(Counter::Transforms),
+        transform_nanos: get(Counter::TransformNanos),
+        actions_applied: get(Counter::ActionsApplied),
+        actions_failed: get(Counter::ActionsFailed),
+        cache_hits: get(Counter::CacheHits),
+        cache_misses: get(Counter::CacheMisses),
+        heap_fallbacks: get(Counter::HeapFallbacks),
+        allocations: get(Counter::Allocations)
+    }
+}
+
+/// Set every counter back to 0
+#[cfg(feature = "metrics")]
+pub fn reset() {
+    for counter in COUNTERS.iter() {
+        counter.store(0, Ordering::Relaxed);
+    }
+}
+
+#[cfg(all(test, feature = "metrics"))]
+mod tests {
+    use super::*;
+
+    // counters are global and tests run in parallel, so only check that
+    // they grow
+    #[test]
+    fn count_actions() {
+        let before = snapshot();
+        let (_, result) = crate::telex::transform_buffer(&['a', 's', 'z', 'z']);
+        assert_eq!(result, "az");
+        let after = snapshot();
+        assert!(after.actions_applied >= before.actions_applied + 2);
+        assert!(after.actions_failed > before.actions_failed);
+        assert!(after.transforms > before.transforms);
+    }
+
+    #[test]
+    fn count_heap_fallbacks() {
+        let before = snapshot();
+        crate::vni::transform_buffer(&['a'; 20]);
+        let after = snapshot();
+        assert!(after.heap_fallbacks > before.heap_fallbacks);
+        assert!(after.allocations > before.allocations);
+    }
+}
@@ -0,0 +1,237 @@
+use std::fmt;
+use super::decomposition::{decompose, add_tone_mark, add_modification};
+use super::processor::{ToneMark, LetterModification};
+
+/// The unicode normalization form of the output text
+///
+/// - **Nfc:** Precomposed letters, such as `ấ` as a single char.
+/// - **Nfd:** Base letters followed by combining marks, such as `ấ` as
+/// `a` + U+0302 + U+0301. `đ` has no decomposition and stays as is.
+#[derive(Debug, PartialEq, Clone, Copy)]
+pub enum Form {
+    Nfc,
+    Nfd
+}
+
+impl Default for Form {
+    fn default() -> Self {
+        Form::Nfc
+    }
+}
+
+/// A combining mark of the vietnamese repertoire
+#[derive(Debug, PartialEq, Clone, Copy)]
+enum Mark {
+    Tone(ToneMark),
+    Modification(LetterModification)
+}
+
+fn tone_mark_char(tone_mark: &ToneMark) -> char {
+    match tone_mark {
+        ToneMark::Acute     => '\u{301}',
+        ToneMark::Grave     => '\u{300}',
+        ToneMark::HookAbove => '\u{309}',
+        ToneMark::Tilde     => '\u{303}',
+        ToneMark::Underdot  => '\u{323}'
+    }
+}
+
+fn modification_char(modification: &LetterModification) -> Option<char> {
+    match modification {
+        LetterModification::Circumflex => Some('\u{302}'),
+        LetterModification::Breve      => Some('\u{306}'),
+        LetterModification::Horn       => Some('\u{31b}'),
+        LetterModification::Dyet       => None
+    }
+}
+
+fn combining_mark(ch: char) -> Option<Mark> {
+    match ch {
+        '\u{301}' => Some(Mark::Tone(ToneMark::Acute)),
+        '\u{300}' => Some(Mark::Tone(ToneMark::Grave)),
+        '\u{309}' => Some(Mark::Tone(ToneMark::HookAbove)),
+        '\u{303}' => Some(Mark::Tone(ToneMark::Tilde)),
+        '\u{323}' => Some(Mark::Tone(ToneMark::Underdot)),
+        '\u{302}' => Some(Mark::Modification(LetterModification::Circumflex)),
+        '\u{306}' => Some(Mark::Modification(LetterModification::Breve)),
+        '\u{31b}' => Some(Mark::Modification(LetterModification::Horn)),
+        _ => None
+    }
+}
+
+/// Canonical combining class of a mark, which decides the order of marks
+/// in the decomposed form: the horn (216) goes before the underdot (220)
+/// which goes before every mark above the letter (230).
+fn combining_class(mark: char) -> u8 {
+    match mark {
+        '\u{31b}' => 216,
+        '\u{323}' => 220,
+        _ => 230
+    }
+}
+
+/// Apply a combining mark to a precomposed letter.
+/// Return `None` if the letter can't take the mark.
+fn apply_mark(ch: char, mark: Mark) -> Option<char> {
+    let (base, modification, tone_mark) = decompose(ch);
+    match mark {
+        Mark::Tone(mark) if tone_mark.is_none() => add_tone_mark(ch, &mark),
+        Mark::Modification(mark) if modification.is_none() => {
+            let modified = add_modification(base, &mark)?;
+            match tone_mark {
+                Some(tone_mark) => add_tone_mark(modified, &tone_mark),
+                None => Some(modified)
+            }
+        }
+        _ => None
+    }
+}
+
+/// Write the decomposed form of a letter to `output`
+pub fn decompose_char(ch: char, output: &mut String) {
+    write_decomposed_char(ch, output).expect("writing to a String never fails")
+}
+
+fn write_decomposed_char<W: fmt::Write>(ch: char, output: &mut W) -> fmt::Result {
+    let (base, modification, tone_mark) = decompose(ch);
+    let mut marks = [None, None];
+    match modification {
+        Some(LetterModification::Dyet) => output.write_char(ch)?,
+        Some(modification) => {
+            output.write_char(base)?;
+            marks[0] = modification_char(&modification);
+        }
+        None => output.write_char(base)?
+    }
+    marks[1] = tone_mark.as_ref().map(tone_mark_char);
+    if let [Some(first), Some(second)] = marks {
+        if combining_class(second) < combining_class(first) {
+            marks.swap(0, 1);
+        }
+    }
+    for mark in marks.iter().flatten() {
+        output.write_char(*mark)?;
+    }
+    Ok(())
+}
+
+/// Append the decomposed (NFD) form of a text to `output`. Only the
+/// vietnamese letters are decomposed, other chars are copied as is.
+///
+/// # Example
+/// ```
+/// use vi::normalize::to_nfd;
+///
+/// let mut result = String::new();
+/// to_nfd("việt", &mut result);
+/// assert_eq!(result, "vie\u{323}\u{302}t");
+/// ```
+pub fn to_nfd(input: &str, output: &mut String) {
+    if input.is_ascii() {
+        output.push_str(input);
+        return;
+    }
+    output.reserve(input.len());
+    write_nfd(input, output).expect("writing to a String never fails")
+}
+
+/// Same as `to_nfd` for any writer, such as the inline buffers of the
+/// engine
+pub(crate) fn write_nfd<W: fmt::Write>(input: &str, output: &mut W) -> fmt::Result {
+    if input.is_ascii() {
+        return output.write_str(input);
+    }
+    for ch in input.chars() {
+        if ch.is_ascii() {
+            output.write_char(ch)?;
+        } else {
+            write_decomposed_char(ch, output)?;
+        }
+    }
+    Ok(())
+}
+
+/// Append the precomposed (NFC) form of a text to `output`. Combining marks
+/// are merged into the letter before them when the vietnamese repertoire
+/// has such a letter, in any order. Marks that can't be merged are kept.
+///
+/// # Example
+/// ```
+/// use vi::normalize::to_nfc;
+///
+/// let mut result = String::new();
+/// to_nfc("vie\u{323}\u{302}t", &mut result);
+/// assert_eq!(result, "việt");
+/// ```
+pub fn to_nfc(input: &str, output: &mut String) {
+    if input.is_ascii() {
+        output.push_str(input);
+        return;
+    }
+    output.reserve(input.len());
+    let mut chars = input.chars().peekable();
+    while let Some(ch) = chars.next() {
+        let mut composed = ch;
+        while let Some(mark) = chars.peek().and_then(|next| combining_mark(*next)) {
+            match apply_mark(composed, mark) {
+                Some(next) => composed = next,
+                None => break
+            }
+            chars.next();
+        }
+        output.push(composed);
+    }
+}
+
+/// Append a text to `output` in the given form
+pub fn normalize(input: &str, form: Form, output: &mut String) {
+    match form {
+        Form::Nfc => to_nfc(input, output),
+        Form::Nfd => to_nfd(input, output)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn nfd(input: &str) -> String {
+        let mut result = String::new();
+        to_nfd(input, &mut result);
+        result
+    }
+
+    fn nfc(input: &str) -> String {
+        let mut result = String::new();
+        to_nfc(input, &mut result);
+        result
+    }
+
+    #[test]
+    fn nfd_canonical_order() {
+        assert_eq!(nfd("ấ"), "a\u{302}\u{301}");
+        assert_eq!(nfd("ự"), "u\u{31b}\u{323}");
+        assert_eq!(nfd("Ặ"), "A\u{323}\u{306}");
+        assert_eq!(nfd("đá"), "đa\u{301}");
+    }
+
+    #[test]
+    fn nfc_any_order() {
+        assert_eq!(nfc("a\u{302}\u{301}"), "ấ");
+        assert_eq!(nfc("a\u{301}\u{302}"), "ấ");
+        assert_eq!(nfc("ơ\u{300}"), "ờ");
+    }
+
+    #[test]
+    fn nfc_keep_unknown_marks() {
+        assert_eq!(nfc("b\u{301}"), "b\u{301}");
+        assert_eq!(nfc("á\u{301}"), "á\u{301}");
+        assert_eq!(nfc("\u{301}a"), "\u{301}a");
+    }
+
+    #[test]
+    fn round_trip() {
+        let text = "Người Việt Nam, đường phố Hà Nội. ỨNG DỤNG";
+        assert_eq!(nfc(&nfd(text)), text);
+    }
+}
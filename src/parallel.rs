@@ -0,0 +1,100 @@
+use rayon::prelude::*;
+use super::vni;
+
+/// Size in bytes of the chunks transformed by each thread
+pub const CHUNK_SIZE: usize = 64 * 1024;
+
+/// Transform a whole text across all cores and append the result to
+/// `output`. The text is split into chunks on word boundaries, each chunk
+/// is transformed with `vni::transform_str` and the results are joined
+/// back in order, so the output is the same as a single threaded run.
+///
+/// # Example
+/// ```
+/// use vi::parallel::transform_str;
+///
+/// let mut result = String::new();
+/// transform_str("xin chao2 Viet65 Nam", &mut result);
+/// assert_eq!(result, "xin chào Việt Nam");
+/// ```
+pub fn transform_str(input: &str, output: &mut String) {
+    transform_str_with_chunk_size(input, output, CHUNK_SIZE)
+}
+
+/// Same as `transform_str` with a custom chunk size
+pub fn transform_str_with_chunk_size(input: &str, output: &mut String, chunk_size: usize) {
+    let chunks: Vec<&str> = split_at_word_boundaries(input, chunk_size).collect();
+    let results: Vec<String> = chunks
+        .par_iter()
+        .map(|chunk| {
+            let mut result = String::with_capacity(chunk.len());
+            vni::transform_str(chunk, &mut result);
+            result
+        })
+        .collect();
+    output.reserve(results.iter().map(String::len).sum());
+    for result in results {
+        output.push_str(&result);
+    }
+}
+
+/// Split a text into chunks of at least `chunk_size` bytes without cutting
+/// through a word. Each chunk ends right before a char that is neither a
+/// letter nor a number, or at the end of the text.
+fn split_at_word_boundaries(input: &str, chunk_size: usize) -> WordChunks<'_> {
+    WordChunks { input, chunk_size: chunk_size.max(1) }
+}
+
+struct WordChunks<'a> {
+    input: &'a str,
+    chunk_size: usize
+}
+
+impl<'a> Iterator for WordChunks<'a> {
+    type Item = &'a str;
+
+    fn next(&mut self) -> Option<&'a str> {
+        if self.input.is_empty() {
+            return None;
+        }
+        let mut end = self.input.len().min(self.chunk_size);
+        while !self.input.is_char_boundary(end) {
+            end += 1;
+        }
+        let boundary = self.input[end..]
+            .char_indices()
+            .find(|(_, ch)| !ch.is_alphanumeric())
+            .map(|(index, _)| end + index)
+            .unwrap_or(self.input.len());
+        let (chunk, rest) = self.input.split_at(boundary);
+        self.input = rest;
+        Some(chunk)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn transform_str_same_as_single_thread() {
+        let input = "xin chao2 toi6 la2 Hung7, toi6 den961 tu72 Viet65 Nam\n".repeat(50);
+        let mut expected = String::new();
+        vni::transform_str(&input, &mut expected);
+        let mut result = String::new();
+        transform_str_with_chunk_size(&input, &mut result, 7);
+        assert_eq!(result, expected);
+    }
+
+    #[test]
+    fn split_at_word_boundaries_keep_words() {
+        let chunks: Vec<&str> = split_at_word_boundaries("toi6 den961 tu72", 2).collect();
+        assert_eq!(chunks, vec!["toi6", " den961", " tu72"]);
+    }
+
+    #[test]
+    fn split_at_word_boundaries_multibyte() {
+        let chunks: Vec<&str> = split_at_word_boundaries("đi, về", 1).collect();
+        assert_eq!(chunks, vec!["đi", ",", " về"]);
+    }
+}
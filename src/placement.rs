@@ -0,0 +1,181 @@
+//! Tone mark placement looked up in a table computed at compile time,
+//! used by the syllable instead of the placement rules when the
+//! `placement-table` feature is on.
+//!
+//! Only tone placement is tabulated: for each tone style, the table maps
+//! a vowel of up to `MAX_TABLE_VOWEL_LENGTH` letters, ending the word or
+//! not, to the letter taking the tone mark. It is not a full keystroke
+//! automaton or transducer. Keys are still
+//! applied by the syllable code, the table only replaces the rules that
+//! pick the tone mark position.
+
+use super::processor::LetterModification;
+use super::syllable::ToneStyle;
+
+/// Number of distinct vowel letters: a ă â e ê i o ô ơ u ư y
+const VOWEL_COUNT: usize = 12;
+
+/// Longest vowel covered by the table. Every vietnamese vowel fits,
+/// longer runs of vowels fall back to the rules.
+pub const MAX_TABLE_VOWEL_LENGTH: usize = 3;
+
+const TABLE_SIZE: usize = VOWEL_COUNT * VOWEL_COUNT * (VOWEL_COUNT + 1);
+
+// codes of the letters used by the rules
+const A: u8 = 0;
+const E: u8 = 3;
+const O: u8 = 6;
+const O_HORN: u8 = 8;
+const U: u8 = 9;
+const Y: u8 = 11;
+const BASE_LETTERS: [u8; VOWEL_COUNT] = [A, A, A, E, E, 5, O, O, O, U, U, Y];
+const IS_MODIFIED: [bool; VOWEL_COUNT] = [
+    false, true, true, false, true, false, false, true, true, false, true, false
+];
+
+/// Code of a vowel letter, or `None` if it is not a vietnamese vowel
+fn vowel_code(letter: char, modification: Option<LetterModification>) -> Option<u8> {
+    use LetterModification::*;
+    let code = match (letter, modification) {
+        ('a', None) => 0,
+        ('a', Some(Breve)) => 1,
+        ('a', Some(Circumflex)) => 2,
+        ('e', None) => 3,
+        ('e', Some(Circumflex)) => 4,
+        ('i', None) => 5,
+        ('o', None) => 6,
+        ('o', Some(Circumflex)) => 7,
+        ('o', Some(Horn)) => 8,
+        ('u', None) => 9,
+        ('u', Some(Horn)) => 10,
+        ('y', None) => 11,
+        _ => return None
+    };
+    Some(code)
+}
+
+/// Index of a vowel of two or three letters in the table. The third code
+/// is `VOWEL_COUNT` for a vowel of two letters.
+const fn table_index(first: u8, second: u8, third: u8) -> usize {
+    (first as usize * VOWEL_COUNT + second as usize) * (VOWEL_COUNT + 1) + third as usize
+}
+
+/// The placement rules of `Syllable::tone_mark_position_by_rules` over
+/// letter codes, evaluated at compile time
+const fn place(codes: [u8; MAX_TABLE_VOWEL_LENGTH], len: usize, ends_word: bool, old_style: bool) -> u8 {
+    let mut index = 0;
+    while index < len {
+        if codes[index] == O_HORN {
+            return index as u8;
+        }
+        index += 1;
+    }
+    index = 0;
+    while index < len {
+        if IS_MODIFIED[codes[index] as usize] {
+            return index as u8;
+        }
+        index += 1;
+    }
+    let pairs = [(O, A), (O, E), (O, O), (U, Y)];
+    let mut pair = 0;
+    while pair < pairs.len() {
+        let (first, second) = pairs[pair];
+        index = 0;
+        while index < len && BASE_LETTERS[codes[index] as usize] != first {
+            index += 1;
+        }
+        if index + 1 < len && BASE_LETTERS[codes[index + 1] as usize] == second {
+            if old_style && ends_word && index + 2 == len && second != O {
+                return index as u8;
+            }
+            return index as u8 + 1;
+        }
+        pair += 1;
+    }
+    if ends_word {
+        return len as u8 - 2;
+    }
+    0
+}
+
+/// Tone mark offset of every vowel of two or three letters, for when the
+/// vowel ends the word and for when a final consonant follows
+const fn build_table(old_style: bool) -> [[u8; 2]; TABLE_SIZE] {
+    let mut table = [[0; 2]; TABLE_SIZE];
+    let mut first = 0;
+    while first < VOWEL_COUNT as u8 {
+        let mut second = 0;
+        while second < VOWEL_COUNT as u8 {
+            let mut third = 0;
+            while third <= VOWEL_COUNT as u8 {
+                let len = if third == VOWEL_COUNT as u8 { 2 } else { 3 };
+                let codes = [first, second, third];
+                let index = table_index(first, second, third);
+                table[index] = [place(codes, len, true, old_style), place(codes, len, false, old_style)];
+                third += 1;
+            }
+            second += 1;
+        }
+        first += 1;
+    }
+    table
+}
+
+static NEW_STYLE_OFFSETS: [[u8; 2]; TABLE_SIZE] = build_table(false);
+static OLD_STYLE_OFFSETS: [[u8; 2]; TABLE_SIZE] = build_table(true);
+
+/// Look the tone mark offset of a vowel up in the precomputed table.
+/// Return `None` if the vowel is not covered by it.
+pub fn lookup(
+    letters: &[char],
+    modifications: &[Option<LetterModification>],
+    ends_word: bool,
+    tone_style: ToneStyle
+) -> Option<usize> {
+    if letters.len() == 1 {
+        return Some(0);
+    }
+    if letters.len() > MAX_TABLE_VOWEL_LENGTH {
+        return None;
+    }
+    let mut codes = [VOWEL_COUNT as u8; MAX_TABLE_VOWEL_LENGTH];
+    for (index, letter) in letters.iter().enumerate() {
+        codes[index] = vowel_code(*letter, modifications[index])?;
+    }
+    let table = match tone_style {
+        ToneStyle::New => &NEW_STYLE_OFFSETS,
+        ToneStyle::Old => &OLD_STYLE_OFFSETS
+    };
+    let offsets = table[table_index(codes[0], codes[1], codes[2])];
+    Some(offsets[if ends_word { 0 } else { 1 }] as usize)
+}
+
+#[cfg(test)]
+mod tests {
+    use crate::syllable::{Syllable, ToneStyle};
+
+    const VOWEL_LETTERS: [char; 12] = ['a', 'ă', 'â', 'e', 'ê', 'i', 'o', 'ô', 'ơ', 'u', 'ư', 'y'];
+
+    #[test]
+    fn table_same_as_rules() {
+        let mut vowels: Vec<String> = Vec::new();
+        for first in VOWEL_LETTERS.iter() {
+            for second in VOWEL_LETTERS.iter() {
+                vowels.push([*first, *second].iter().collect());
+                for third in VOWEL_LETTERS.iter() {
+                    vowels.push([*first, *second, *third].iter().collect());
+                }
+            }
+        }
+        for vowel in vowels {
+            for word in [format!("b{}", vowel), format!("b{}n", vowel)].iter() {
+                let mut syllable = Syllable::parse(word).unwrap();
+                for tone_style in [ToneStyle::New, ToneStyle::Old].iter() {
+                    syllable.set_tone_style(*tone_style);
+                    assert_eq!(syllable.tone_mark_position(), syllable.tone_mark_position_by_rules(), "{}", word);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,207 @@
+use super::engine::{Delta, Engine};
+use super::inline::InlineString;
+use super::method::InputMethod;
+
+/// A handle to a session of a `SessionPool`. The generation tells apart
+/// the sessions that reused the same slot, so a handle of a closed session
+/// never reaches the session opened after it.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct SessionId {
+    index: u32,
+    generation: u32
+}
+
+struct Slot {
+    generation: u32,
+    engine: Option<Engine>
+}
+
+/// Many typing sessions sharing an input method, such as the text fields
+/// of a server side IME. The engines live in a contiguous slab with their
+/// word and undo history stored inline, and the slots of closed sessions
+/// are reused. A slot takes around 600 bytes on 64 bit targets: the undo
+/// history keeps a 10 byte snapshot for each of the last
+/// `MAX_HISTORY_LENGTH` keys, next to the syllable and the 64 bytes of the
+/// view. A session only reaches the heap while its word is a token too
+/// long for a syllable, which the engine edits as a `String`, or longer
+/// than the 64 bytes its view holds inline.
+///
+/// # Example
+/// ```
+/// use vi::pool::SessionPool;
+/// use vi::vni::VNI;
+///
+/// let mut pool = SessionPool::new(&VNI);
+/// let first = pool.open();
+/// let second = pool.open();
+/// pool.feed(first, "xin chao2");
+/// let delta = pool.feed(second, "viet65").unwrap();
+/// assert_eq!(delta.insert, "việt");
+/// assert_eq!(pool.get(first).unwrap().view(), "chào");
+///
+/// pool.close(first);
+/// assert!(pool.feed(first, "a").is_none());
+/// ```
+pub struct SessionPool {
+    method: &'static InputMethod,
+    slots: Vec<Slot>,
+    free: Vec<u32>,
+    len: usize
+}
+
+impl SessionPool {
+    pub fn new(method: &'static InputMethod) -> Self {
+        SessionPool::with_capacity(method, 0)
+    }
+
+    /// Create a pool with room for `capacity` sessions
+    pub fn with_capacity(method: &'static InputMethod, capacity: usize) -> Self {
+        SessionPool {
+            method,
+            slots: Vec::with_capacity(capacity),
+            free: Vec::new(),
+            len: 0
+        }
+    }
+
+    /// Number of open sessions
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    /// Open a new session, reusing the slot of a closed one if any
+    pub fn open(&mut self) -> SessionId {
+        self.len += 1;
+        let engine = Engine::new(self.method);
+        if let Some(index) = self.free.pop() {
+            let slot = &mut self.slots[index as usize];
+            slot.engine = Some(engine);
+            return SessionId { index, generation: slot.generation };
+        }
+        let index = self.slots.len() as u32;
+        self.slots.push(Slot { generation: 0, engine: Some(engine) });
+        SessionId { index, generation: 0 }
+    }
+
+    /// Close a session. Return `false` if it was already closed.
+    pub fn close(&mut self, id: SessionId) -> bool {
+        if self.get(id).is_none() {
+            return false;
+        }
+        let slot = &mut self.slots[id.index as usize];
+        slot.engine = None;
+        slot.generation = slot.generation.wrapping_add(1);
+        self.free.push(id.index);
+        self.len -= 1;
+        true
+    }
+
+    pub fn contains(&self, id: SessionId) -> bool {
+        self.get(id).is_some()
+    }
+
+    /// Get the engine of a session, or `None` if it has been closed
+    pub fn get(&self, id: SessionId) -> Option<&Engine> {
+        match self.slots.get(id.index as usize) {
+            Some(slot) if slot.generation == id.generation => slot.engine.as_ref(),
+            _ => None
+        }
+    }
+
+    pub fn get_mut(&mut self, id: SessionId) -> Option<&mut Engine> {
+        match self.slots.get_mut(id.index as usize) {
+            Some(slot) if slot.generation == id.generation => slot.engine.as_mut(),
+            _ => None
+        }
+    }
+
+    /// Feed a batch of keys to a session and return the single edit that
+    /// brings the text on screen up to date, or `None` if the session has
+    /// been closed. A key that ends a word, such as a space, commits the
+    /// word and is typed as is.
+    pub fn feed(&mut self, id: SessionId, keys: &str) -> Option<Delta> {
+        let method = self.method;
+        let engine = self.get_mut(id)?;
+        let old_view = InlineString::from(engine.view());
+        let mut committed = InlineString::new();
+        for key in keys.chars() {
+            if method.is_word_char(key) {
+                engine.push(key);
+            } else {
+                engine.write_word(&mut committed).expect("writing to an InlineString never fails");
+                engine.reset();
+                committed.push(key);
+            }
+        }
+        committed.push_str(engine.view());
+        Some(Delta::between(&old_view, &committed))
+    }
+
+    /// Feed the keys of many sessions at once, such as all the events of a
+    /// tick, and append an edit per session to `deltas` in order
+    pub fn feed_batch<'a, I>(&mut self, batch: I, deltas: &mut Vec<Option<Delta>>)
+    where
+        I: IntoIterator<Item = (SessionId, &'a str)>
+    {
+        for (id, keys) in batch {
+            deltas.push(self.feed(id, keys));
+        }
+    }
+
+    /// Finish the word of a session and return it, or `None` if the
+    /// session has been closed
+    pub fn commit(&mut self, id: SessionId) -> Option<String> {
+        self.get_mut(id).map(Engine::commit)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::telex::TELEX;
+
+    #[test]
+    fn slot_size() {
+        assert!(std::mem::size_of::<Slot>() <= 640);
+    }
+
+    #[test]
+    fn reuse_slots() {
+        let mut pool = SessionPool::new(&TELEX);
+        let first = pool.open();
+        assert!(pool.close(first));
+        assert!(!pool.close(first));
+        let second = pool.open();
+        assert_eq!(second.index, first.index);
+        assert_ne!(second, first);
+        assert!(!pool.contains(first));
+        assert!(pool.contains(second));
+        assert_eq!(pool.len(), 1);
+    }
+
+    #[test]
+    fn feed_across_words() {
+        let mut pool = SessionPool::new(&TELEX);
+        let id = pool.open();
+        pool.feed(id, "toi");
+        let delta = pool.feed(id, "s ddi").unwrap();
+        assert_eq!(delta, Delta { backspace_count: 2, insert: "ói đi".into() });
+        assert_eq!(pool.commit(id).unwrap(), "đi");
+    }
+
+    #[test]
+    fn feed_batch_in_order() {
+        let mut pool = SessionPool::new(&TELEX);
+        let (first, second) = (pool.open(), pool.open());
+        pool.close(second);
+        let mut deltas = Vec::new();
+        pool.feed_batch(vec![(first, "as"), (second, "a"), (first, "z")], &mut deltas);
+        assert_eq!(deltas[0].as_ref().unwrap().insert, "á");
+        assert_eq!(deltas[1], None);
+        assert_eq!(deltas[2].as_ref().unwrap().insert, "a");
+    }
+}
@@ -0,0 +1,245 @@
+use std::io::{self, BufRead, Read, Write};
+use std::str;
+use super::method::{InputMethod, MAX_WORD_LENGTH};
+use super::vni;
+
+/// Longest unfinished word kept around while waiting for more input.
+/// A longer word is copied as is until it ends, as `transform_str` does.
+pub const MAX_PENDING_WORD_LENGTH: usize = MAX_WORD_LENGTH;
+
+fn invalid_utf8() -> io::Error {
+    io::Error::new(io::ErrorKind::InvalidData, "stream did not contain valid UTF-8")
+}
+
+/// The state carried across buffer boundaries: the unfinished word at the
+/// end of the input seen so far, along with any incomplete UTF-8 sequence.
+pub(crate) struct Converter {
+    method: &'static InputMethod,
+    pending: Vec<u8>,
+    /// In a word longer than `MAX_PENDING_WORD_LENGTH`, copied as is
+    /// until its end
+    copying: bool
+}
+
+impl Converter {
+    pub(crate) fn new(method: &'static InputMethod) -> Self {
+        Converter { method, pending: Vec::new(), copying: false }
+    }
+
+    /// Transform every finished word of `bytes` into `output` and keep the
+    /// unfinished word for later
+    pub(crate) fn feed(&mut self, bytes: &[u8], output: &mut String) -> io::Result<()> {
+        self.pending.extend_from_slice(bytes);
+        let text = match str::from_utf8(&self.pending) {
+            Ok(text) => text,
+            Err(error) if error.error_len().is_none() => {
+                str::from_utf8(&self.pending[..error.valid_up_to()]).unwrap()
+            }
+            Err(_) => return Err(invalid_utf8())
+        };
+        let method = self.method;
+        let mut start = 0;
+        if self.copying {
+            start = text.find(|ch| !method.is_word_char(ch)).unwrap_or(text.len());
+            output.push_str(&text[..start]);
+            self.copying = start == text.len();
+        }
+        let text = &text[start..];
+        let split = match text.char_indices().rev().find(|(_, ch)| !method.is_word_char(*ch)) {
+            Some((index, ch)) => index + ch.len_utf8(),
+            None => 0
+        };
+        method.transform_str(&text[..split], output);
+        let mut consumed = start + split;
+        if text.len() - split > MAX_PENDING_WORD_LENGTH {
+            output.push_str(&text[split..]);
+            self.copying = true;
+            consumed = start + text.len();
+        }
+        self.pending.drain(..consumed);
+        Ok(())
+    }
+
+    /// Transform the unfinished word, the input is over
+    pub(crate) fn finish(&mut self, output: &mut String) -> io::Result<()> {
+        let text = str::from_utf8(&self.pending).map_err(|_| invalid_utf8())?;
+        if self.copying {
+            output.push_str(text);
+        } else {
+            self.method.transform_str(text, output);
+        }
+        self.pending.clear();
+        self.copying = false;
+        Ok(())
+    }
+}
+
+/// A reader that transform vni input from the underlying reader as it
+/// is read. Only the unfinished word at the end of each buffer is kept
+/// between reads, so unbounded input is converted with constant memory.
+///
+/// # Example
+/// ```
+/// use std::io::Read;
+/// use vi::stream::VniReader;
+///
+/// let mut reader = VniReader::new("xin chao2 Viet65 Nam".as_bytes());
+/// let mut result = String::new();
+/// reader.read_to_string(&mut result).unwrap();
+/// assert_eq!(result, "xin chào Việt Nam");
+/// ```
+pub struct VniReader<R> {
+    inner: R,
+    converter: Converter,
+    output: String,
+    position: usize,
+    done: bool
+}
+
+impl<R: BufRead> VniReader<R> {
+    pub fn new(inner: R) -> Self {
+        VniReader {
+            inner,
+            converter: Converter::new(&vni::VNI),
+            output: String::new(),
+            position: 0,
+            done: false
+        }
+    }
+
+    pub fn into_inner(self) -> R {
+        self.inner
+    }
+}
+
+impl<R: BufRead> BufRead for VniReader<R> {
+    fn fill_buf(&mut self) -> io::Result<&[u8]> {
+        while self.position == self.output.len() && !self.done {
+            self.output.clear();
+            self.position = 0;
+            let available = self.inner.fill_buf()?;
+            if available.is_empty() {
+                self.converter.finish(&mut self.output)?;
+                self.done = true;
+            } else {
+                let len = available.len();
+                self.converter.feed(available, &mut self.output)?;
+                self.inner.consume(len);
+            }
+        }
+        Ok(&self.output.as_bytes()[self.position..])
+    }
+
+    fn consume(&mut self, amt: usize) {
+        self.position = (self.position + amt).min(self.output.len());
+    }
+}
+
+impl<R: BufRead> Read for VniReader<R> {
+    fn read(&mut self, buf: &mut [u8]) -> io::Result<usize> {
+        let available = self.fill_buf()?;
+        let len = available.len().min(buf.len());
+        buf[..len].copy_from_slice(&available[..len]);
+        self.consume(len);
+        Ok(len)
+    }
+}
+
+/// A writer that transform vni input before writing it to the underlying
+/// writer. The unfinished word at the end of each write is held back until
+/// the word ends, so `finish` must be called once the input is over.
+///
+/// # Example
+/// ```
+/// use std::io::Write;
+/// use vi::stream::VniWriter;
+///
+/// let mut writer = VniWriter::new(Vec::new());
+/// writer.write_all(b"xin chao2 Vi").unwrap();
+/// writer.write_all(b"et65 Nam").unwrap();
+/// let result = writer.finish().unwrap();
+/// assert_eq!(String::from_utf8(result).unwrap(), "xin chào Việt Nam");
+/// ```
+pub struct VniWriter<W: Write> {
+    inner: W,
+    converter: Converter,
+    output: String
+}
+
+impl<W: Write> VniWriter<W> {
+    pub fn new(inner: W) -> Self {
+        VniWriter {
+            inner,
+            converter: Converter::new(&vni::VNI),
+            output: String::new()
+        }
+    }
+
+    /// Transform the unfinished word, flush and return the underlying writer
+    pub fn finish(mut self) -> io::Result<W> {
+        self.converter.finish(&mut self.output)?;
+        self.inner.write_all(self.output.as_bytes())?;
+        self.inner.flush()?;
+        Ok(self.inner)
+    }
+}
+
+impl<W: Write> Write for VniWriter<W> {
+    fn write(&mut self, buf: &[u8]) -> io::Result<usize> {
+        self.converter.feed(buf, &mut self.output)?;
+        self.inner.write_all(self.output.as_bytes())?;
+        self.output.clear();
+        Ok(buf.len())
+    }
+
+    fn flush(&mut self) -> io::Result<()> {
+        self.inner.flush()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::io::BufReader;
+
+    const INPUT: &str = "xin chao2 toi6 la2 Hung7, toi6 den961 tu72 Viet65 Nam\n";
+    const EXPECTED: &str = "xin chào tôi là Hưng, tôi đến từ Việt Nam\n";
+
+    #[test]
+    fn reader_small_buffer() {
+        let inner = BufReader::with_capacity(3, INPUT.as_bytes());
+        let mut result = String::new();
+        VniReader::new(inner).read_to_string(&mut result).unwrap();
+        assert_eq!(result, EXPECTED);
+    }
+
+    #[test]
+    fn reader_long_word() {
+        let input = format!("{}1 viet65", "ab".repeat(150) + "a");
+        let mut expected = String::new();
+        vni::transform_str(&input, &mut expected);
+        assert!(expected.ends_with("ababa1 việt"));
+        for capacity in &[1, 7, 64, 256, 300, 1024] {
+            let inner = BufReader::with_capacity(*capacity, input.as_bytes());
+            let mut result = String::new();
+            VniReader::new(inner).read_to_string(&mut result).unwrap();
+            assert_eq!(result, expected, "capacity {}", capacity);
+        }
+    }
+
+    #[test]
+    fn writer_byte_by_byte() {
+        let mut writer = VniWriter::new(Vec::new());
+        for byte in INPUT.as_bytes() {
+            writer.write_all(&[*byte]).unwrap();
+        }
+        let result = writer.finish().unwrap();
+        assert_eq!(String::from_utf8(result).unwrap(), EXPECTED);
+    }
+
+    #[test]
+    fn writer_invalid_utf8() {
+        let mut writer = VniWriter::new(Vec::new());
+        assert!(writer.write_all(&[b'a', 0xff]).is_err());
+    }
+}
@@ -0,0 +1,628 @@
+use std::fmt;
+use std::ops::Range;
+use super::decomposition::{decompose, compose, modification_map};
+use super::processor::{Action, ToneMark, LetterModification};
+use super::tokenizer::VowelScanner;
+#[cfg(feature = "placement-table")]
+use super::placement;
+use super::util::to_lowercase;
+use super::validation;
+
+/// Maximum number of letters a syllable can hold
+pub const MAX_SYLLABLE_LENGTH: usize = 16;
+
+/// Pairs of vowels which take the tone mark on the second vowel
+const TONE_ON_SECOND_PAIRS: [(char, char); 4] = [('o', 'a'), ('o', 'e'), ('o', 'o'), ('u', 'y')];
+
+/// Where the tone mark goes on `oa`, `oe` and `uy` at the end of a word
+///
+/// - **New:** On the second vowel, as in `hoà`, `khoẻ` and `thuỳ`.
+/// - **Old:** On the first vowel, as in `hòa`, `khỏe` and `thùy`.
+///
+/// Both styles agree when a final consonant follows, as in `hoàng`.
+#[derive(Debug, PartialEq, Clone, Copy)]
+pub enum ToneStyle {
+    New,
+    Old
+}
+
+impl Default for ToneStyle {
+    fn default() -> Self {
+        ToneStyle::New
+    }
+}
+
+/// Bits taken by the modification of a letter in a `Snapshot`
+const MODIFICATION_BITS: usize = 3;
+
+/// Bytes holding the modifications of every letter in a `Snapshot`
+const MODIFICATION_BYTES: usize = (MAX_SYLLABLE_LENGTH * MODIFICATION_BITS + 7) / 8;
+
+/// Tone mark position of a `Snapshot` whose tone mark goes where the
+/// placement rules put it once restored
+const PLACE_BY_RULES: u8 = u8::MAX;
+
+fn modification_code(modification: Option<LetterModification>) -> u64 {
+    match modification {
+        None => 0,
+        Some(LetterModification::Circumflex) => 1,
+        Some(LetterModification::Breve) => 2,
+        Some(LetterModification::Horn) => 3,
+        Some(LetterModification::Dyet) => 4
+    }
+}
+
+fn decode_modification(code: u64) -> Option<LetterModification> {
+    match code & ((1 << MODIFICATION_BITS) - 1) {
+        1 => Some(LetterModification::Circumflex),
+        2 => Some(LetterModification::Breve),
+        3 => Some(LetterModification::Horn),
+        4 => Some(LetterModification::Dyet),
+        _ => None
+    }
+}
+
+/// The parts of a syllable a key may change, kept to undo the key in a
+/// few bytes. Keys only ever append letters, so the length stands for the
+/// letters, while the modifications are packed `MODIFICATION_BITS` a
+/// letter. It only holds bytes so a step of the engine history stays
+/// unaligned and small.
+#[derive(Debug, Clone, Copy, PartialEq, Default)]
+pub(crate) struct Snapshot {
+    len: u8,
+    modifications: [u8; MODIFICATION_BYTES],
+    tone_mark: Option<ToneMark>,
+    tone_mark_position: u8
+}
+
+impl Snapshot {
+    pub(crate) fn tone_mark(&self) -> Option<ToneMark> {
+        self.tone_mark
+    }
+
+    /// Change the tone mark, placed by the rules once restored
+    pub(crate) fn set_tone_mark(&mut self, tone_mark: Option<ToneMark>) {
+        self.tone_mark = tone_mark;
+        self.tone_mark_position = PLACE_BY_RULES;
+    }
+}
+
+/// A vietnamese syllable stored in a fixed-size inline buffer.
+///
+/// Each letter is kept as a lowercase base letter with its modification,
+/// while the case of the letters is kept in a bitmask. The syllable hold
+/// a single tone mark along with the position of the letter carrying it.
+/// Tone mark placement and letter modification only work on indices and
+/// the syllable is only rendered back to a string at the end.
+///
+/// # Example
+/// ```
+/// use vi::syllable::Syllable;
+/// use vi::processor::ToneMark;
+///
+/// let mut syllable = Syllable::parse("Hoang").unwrap();
+/// assert_eq!(syllable.initial_consonant(), 0..1);
+/// assert_eq!(syllable.vowel(), 1..3);
+/// assert_eq!(syllable.final_consonant(), 3..5);
+///
+/// syllable.add_tone(&ToneMark::Grave);
+/// assert_eq!(syllable.to_string(), "Hoàng");
+/// ```
+#[derive(Debug, Clone, Copy, PartialEq, Default)]
+pub struct Syllable {
+    letters: [char; MAX_SYLLABLE_LENGTH],
+    modifications: [Option<LetterModification>; MAX_SYLLABLE_LENGTH],
+    len: usize,
+    case_mask: u16,
+    tone_mark: Option<ToneMark>,
+    tone_mark_position: usize,
+    tone_style: ToneStyle,
+    scanner: VowelScanner
+}
+
+impl Syllable {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Create an empty syllable placing tone marks in the given style
+    pub fn with_tone_style(tone_style: ToneStyle) -> Self {
+        Syllable { tone_style, ..Self::default() }
+    }
+
+    pub fn tone_style(&self) -> ToneStyle {
+        self.tone_style
+    }
+
+    /// Change the placement style and move the tone mark to follow it
+    pub fn set_tone_style(&mut self, tone_style: ToneStyle) {
+        self.tone_style = tone_style;
+        self.replace_tone_mark();
+    }
+
+    /// Parse a word into a syllable. Return `None` if the word is longer
+    /// than `MAX_SYLLABLE_LENGTH` or carries more than one tone mark.
+    pub fn parse(word: &str) -> Option<Syllable> {
+        let mut syllable = Syllable::new();
+        for ch in word.chars() {
+            if !syllable.push(ch) {
+                return None;
+            }
+        }
+        Some(syllable)
+    }
+
+    /// Append a letter to the syllable. Return `false` and leave the
+    /// syllable untouched if it is full or if the letter carries a tone
+    /// mark while the syllable already has one.
+    pub fn push(&mut self, ch: char) -> bool {
+        if self.len == MAX_SYLLABLE_LENGTH {
+            return false;
+        }
+        let (base, modification, tone_mark) = decompose(ch);
+        if tone_mark.is_some() {
+            if self.tone_mark.is_some() {
+                return false;
+            }
+            self.tone_mark = tone_mark;
+            self.tone_mark_position = self.len;
+        }
+        let (letter, is_uppercase) = to_lowercase(base);
+        if is_uppercase {
+            self.case_mask |= 1 << self.len;
+        }
+        self.letters[self.len] = letter;
+        self.modifications[self.len] = modification;
+        self.len += 1;
+        self.scanner.push(letter, modification.is_some(), ch.len_utf8());
+        true
+    }
+
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    pub fn tone_mark(&self) -> Option<ToneMark> {
+        self.tone_mark
+    }
+
+    /// Get the first modification found in the syllable
+    pub fn modification(&self) -> Option<LetterModification> {
+        self.modifications[..self.len].iter().find_map(|modification| *modification)
+    }
+
+    /// Check if the syllable can still become a vietnamese syllable as
+    /// more letters are typed, see `validation::is_valid_prefix`
+    pub fn is_valid_prefix(&self) -> bool {
+        let letters = self.letters[..self.len].iter().copied();
+        let modifications = self.modifications[..self.len].iter().map(Option::is_some);
+        validation::check_letters(letters.zip(modifications), false)
+    }
+
+    /// Letters before the vowel
+    pub fn initial_consonant(&self) -> Range<usize> {
+        0..self.vowel().start
+    }
+
+    /// The main sound of the syllable which start with a vowel and end
+    /// with the word end or a non-vowel letter
+    pub fn vowel(&self) -> Range<usize> {
+        self.scanner.vowel()
+    }
+
+    /// Letters after the vowel
+    pub fn final_consonant(&self) -> Range<usize> {
+        self.vowel().end..self.len
+    }
+
+    /// Get position to place tone mark
+    ///
+    /// # Rules:
+    /// 1. Tone mark always above vowel (a, ă, â, e, ê, i, o, ô, ơ, u, ư, y)
+    /// 2. If a word contains ơ, tone mark goes there
+    /// 3. If a modified letter goes with a non-modified vowel, tone mark should be
+    /// on modifed letter
+    /// 4. If a word contains `oa`, `oe`, `oo`, `uy`, tone mark should be on the
+    /// second vowel, unless the old style is used and `oa`, `oe` or `uy` end
+    /// the word, then it goes on the first one
+    /// 5. If a word end with 2 or 3 vowel, put it on the second last one
+    /// 6. Else, but tone mark on whatever vowel comes first
+    ///
+    /// With the `placement-table` feature, the position of vowels of up to
+    /// three letters is looked up in a table precomputed from these rules.
+    pub fn tone_mark_position(&self) -> Option<usize> {
+        let vowel = self.vowel();
+        if vowel.is_empty() {
+            return None;
+        }
+        #[cfg(feature = "placement-table")]
+        {
+            let ends_word = vowel.end == self.len;
+            let letters = &self.letters[vowel.clone()];
+            let modifications = &self.modifications[vowel.clone()];
+            if let Some(offset) = placement::lookup(letters, modifications, ends_word, self.tone_style) {
+                return Some(vowel.start + offset);
+            }
+        }
+        self.tone_mark_position_by_rules()
+    }
+
+    /// Get position to place tone mark by running the rules of
+    /// `tone_mark_position`. This is the reference the placement table is
+    /// checked against.
+    pub fn tone_mark_position_by_rules(&self) -> Option<usize> {
+        let vowel = self.vowel();
+        if vowel.is_empty() {
+            return None;
+        }
+        if vowel.len() == 1 {
+            return Some(vowel.start);
+        }
+        if let Some(pos) = vowel.clone().find(|index| {
+            self.letters[*index] == 'o' && self.modifications[*index] == Some(LetterModification::Horn)
+        }) {
+            return Some(pos);
+        }
+        if let Some(pos) = vowel.clone().find(|index| self.modifications[*index].is_some()) {
+            return Some(pos);
+        }
+        for (first, second) in TONE_ON_SECOND_PAIRS.iter() {
+            if let Some(pos) = vowel.clone().find(|index| self.letters[*index] == *first) {
+                if pos + 1 < vowel.end && self.letters[pos + 1] == *second {
+                    let ends_word = pos + 2 == self.len;
+                    if self.tone_style == ToneStyle::Old && ends_word && *second != 'o' {
+                        return Some(pos);
+                    }
+                    return Some(pos + 1);
+                }
+            }
+        }
+        if vowel.end == self.len {
+            return Some(vowel.end - 2);
+        }
+        Some(vowel.start)
+    }
+
+    /// Add tone mark to the syllable. Adding the tone mark the syllable
+    /// already has remove it instead.
+    /// Return if the tone mark has been added or not
+    pub fn add_tone(&mut self, tone_mark: &ToneMark) -> bool {
+        if self.tone_mark == Some(*tone_mark) {
+            self.tone_mark = None;
+            return false;
+        }
+        if let Some(position) = self.tone_mark_position() {
+            self.tone_mark = Some(*tone_mark);
+            self.tone_mark_position = position;
+            return true;
+        }
+        false
+    }
+
+    /// Apply a modification to every letter that can take it. Applying a
+    /// modification that the letters already have remove it instead. The
+    /// tone mark follows the new spelling.
+    /// Return if any letter has been modified or not
+    pub fn modify_letter(&mut self, modification: &LetterModification) -> bool {
+        self.toggle_modification(modification, |_| true)
+    }
+
+    /// Apply a modification only to the letters of a character family, for
+    /// example `a` for `aa` in telex. Applying a modification that the
+    /// family already has remove it instead.
+    /// Return if any letter has been modified or not
+    pub fn modify_letter_on_character_family(
+        &mut self,
+        modification: &LetterModification,
+        family: char
+    ) -> bool {
+        let (family, _) = to_lowercase(family);
+        self.toggle_modification(modification, |letter| letter == family)
+    }
+
+    /// Remove the tone mark of the syllable, or all the modifications if
+    /// there is no tone mark.
+    /// Return if anything has been removed or not
+    pub fn remove_tone(&mut self) -> bool {
+        if self.tone_mark.take().is_some() {
+            return true;
+        }
+        let modified = self.modification().is_some();
+        self.clear_modifications(|_, _| true);
+        modified
+    }
+
+    /// Apply an action to the syllable
+    /// Return if the action has been applied or not
+    pub fn apply_action(&mut self, action: &Action) -> bool {
+        match action {
+            Action::AddTone(tone_mark) => self.add_tone(tone_mark),
+            Action::ModifyLetter(modification) => self.modify_letter(modification),
+            Action::ModifyLetterOnCharacterFamily(modification, family) => {
+                self.modify_letter_on_character_family(modification, *family)
+            }
+            Action::RemoveTone => self.remove_tone()
+        }
+    }
+
+    /// Move the tone mark to where the placement rules put it for the
+    /// current letters
+    pub fn replace_tone_mark(&mut self) {
+        if self.tone_mark.is_some() {
+            if let Some(position) = self.tone_mark_position() {
+                self.tone_mark_position = position;
+            }
+        }
+    }
+
+    /// Apply a modification to the letters matching `filter` that can take
+    /// it. If none of them can, remove the modification from those which
+    /// already have it.
+    fn toggle_modification<F: Fn(char) -> bool>(
+        &mut self,
+        modification: &LetterModification,
+        filter: F
+    ) -> bool {
+        let map = modification_map(modification);
+        let mut modified = false;
+        for index in 0..self.len {
+            let letter = self.letters[index];
+            if filter(letter) && map.contains_key(&letter) && self.modifications[index] != Some(*modification) {
+                self.modifications[index] = Some(*modification);
+                modified = true;
+            }
+        }
+        if !modified {
+            self.clear_modifications(|letter, existing| {
+                filter(letter) && existing == *modification
+            });
+            return false;
+        }
+        self.rescan();
+        self.replace_tone_mark();
+        true
+    }
+
+    fn clear_modifications<F: Fn(char, LetterModification) -> bool>(&mut self, filter: F) {
+        let mut cleared = false;
+        for index in 0..self.len {
+            if let Some(existing) = self.modifications[index] {
+                if filter(self.letters[index], existing) {
+                    self.modifications[index] = None;
+                    cleared = true;
+                }
+            }
+        }
+        if cleared {
+            self.rescan();
+            self.replace_tone_mark();
+        }
+    }
+
+    /// Check if the syllable is `other` with one more letter, the tone
+    /// mark being allowed to move
+    pub(crate) fn extends(&self, other: &Syllable) -> bool {
+        let len = other.len;
+        self.len == len + 1
+            && self.letters[..len] == other.letters[..len]
+            && self.modifications[..len] == other.modifications[..len]
+            && self.case_mask & ((1 << len) - 1) == other.case_mask
+            && self.tone_mark == other.tone_mark
+    }
+
+    /// Keep what a key may change, to undo it with `restore`
+    pub(crate) fn snapshot(&self) -> Snapshot {
+        let mut packed = 0;
+        for (index, modification) in self.modifications[..self.len].iter().enumerate() {
+            packed |= modification_code(*modification) << (index * MODIFICATION_BITS);
+        }
+        let mut modifications = [0; MODIFICATION_BYTES];
+        modifications.copy_from_slice(&packed.to_le_bytes()[..MODIFICATION_BYTES]);
+        Snapshot {
+            len: self.len as u8,
+            modifications,
+            tone_mark: self.tone_mark,
+            tone_mark_position: self.tone_mark_position as u8
+        }
+    }
+
+    /// Go back to the syllable a snapshot was taken of. The letters typed
+    /// since then are dropped, the ones before were left as they were.
+    pub(crate) fn restore(&mut self, snapshot: &Snapshot) {
+        let len = snapshot.len as usize;
+        let mut packed = [0; 8];
+        packed[..MODIFICATION_BYTES].copy_from_slice(&snapshot.modifications);
+        let packed = u64::from_le_bytes(packed);
+        for index in len..self.len {
+            self.letters[index] = char::default();
+        }
+        self.len = len;
+        self.case_mask &= ((1u32 << len) - 1) as u16;
+        for index in 0..MAX_SYLLABLE_LENGTH {
+            self.modifications[index] = match index < len {
+                true => decode_modification(packed >> (index * MODIFICATION_BITS)),
+                false => None
+            };
+        }
+        self.rescan();
+        self.tone_mark = snapshot.tone_mark;
+        match snapshot.tone_mark_position {
+            PLACE_BY_RULES => match self.tone_mark_position() {
+                Some(position) => self.tone_mark_position = position,
+                None => self.tone_mark = None
+            },
+            position => self.tone_mark_position = position as usize
+        }
+    }
+
+    /// Locate the vowel again after the modifications changed, as `qư` no
+    /// longer starts with the `qu` consonant
+    fn rescan(&mut self) {
+        self.scanner = VowelScanner::default();
+        for index in 0..self.len {
+            let letter = self.letters[index];
+            self.scanner.push(letter, self.modifications[index].is_some(), letter.len_utf8());
+        }
+    }
+}
+
+impl fmt::Display for Syllable {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        use fmt::Write;
+        for index in 0..self.len {
+            let tone_mark = if index == self.tone_mark_position {
+                self.tone_mark
+            } else {
+                None
+            };
+            let ch = compose(self.letters[index], self.modifications[index], tone_mark);
+            if self.case_mask & (1 << index) != 0 {
+                for upper_ch in ch.to_uppercase() {
+                    f.write_char(upper_ch)?;
+                }
+            } else {
+                f.write_char(ch)?;
+            }
+        }
+        Ok(())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn parse_render_round_trip() {
+        for word in ["việt", "NGƯỜI", "chÊt", "quá", "gì", "đường", "a1b"].iter() {
+            let syllable = Syllable::parse(word).unwrap();
+            assert_eq!(syllable.to_string(), *word);
+        }
+    }
+
+    #[test]
+    fn parse_too_long() {
+        assert_eq!(Syllable::parse("supercalifragilistic"), None);
+    }
+
+    #[test]
+    fn parse_multiple_tone_marks() {
+        assert_eq!(Syllable::parse("áà"), None);
+    }
+
+    #[test]
+    fn vowel_double_start_sound() {
+        let syllable = Syllable::parse("QUAI").unwrap();
+        assert_eq!(syllable.vowel(), 2..4);
+        let syllable = Syllable::parse("giang").unwrap();
+        assert_eq!(syllable.vowel(), 2..3);
+    }
+
+    #[test]
+    fn modify_letter_move_tone_mark() {
+        let mut syllable = Syllable::parse("tuýen").unwrap();
+        assert!(syllable.modify_letter(&LetterModification::Circumflex));
+        assert_eq!(syllable.to_string(), "tuyến");
+    }
+
+    #[test]
+    fn modify_letter_twice() {
+        let mut syllable = Syllable::parse("vươn").unwrap();
+        assert!(!syllable.modify_letter(&LetterModification::Horn));
+        assert_eq!(syllable.to_string(), "vuon");
+    }
+
+    #[test]
+    fn snapshot_restore() {
+        let mut syllable = Syllable::parse("Ngươi").unwrap();
+        let snapshot = syllable.snapshot();
+        let before = syllable.to_string();
+        syllable.push('N');
+        syllable.push('G');
+        syllable.modify_letter(&LetterModification::Horn);
+        syllable.add_tone(&ToneMark::Grave);
+        syllable.restore(&snapshot);
+        assert_eq!(syllable.to_string(), before);
+        assert_eq!(syllable.snapshot(), snapshot);
+
+        let mut retoned = snapshot;
+        retoned.set_tone_mark(Some(ToneMark::Grave));
+        syllable.restore(&retoned);
+        assert_eq!(syllable.to_string(), "Người");
+    }
+
+    #[test]
+    fn get_tone_mark_placement_normal() {
+        let result = Syllable::parse("choe").unwrap().tone_mark_position();
+        let expected: Option<usize> = Some(3);
+        assert_eq!(result, expected);
+    }
+
+    #[test]
+    fn get_tone_mark_placement_special() {
+        let result = Syllable::parse("chieu").unwrap().tone_mark_position();
+        let expected: Option<usize> = Some(3);
+        assert_eq!(result, expected);
+    }
+
+    #[test]
+    fn get_tone_mark_placement_mid_not_end() {
+        let result = Syllable::parse("hoang").unwrap().tone_mark_position();
+        let expected: Option<usize> = Some(2);
+        assert_eq!(result, expected);
+    }
+
+    #[test]
+    fn get_tone_mark_placement_u_and_o() {
+        let result = Syllable::parse("ngươi").unwrap().tone_mark_position();
+        let expected: Option<usize> = Some(3);
+        assert_eq!(result, expected);
+    }
+
+    #[test]
+    fn get_tone_mark_placement_uppercase() {
+        let result = Syllable::parse("chÊt").unwrap().tone_mark_position();
+        let expected: Option<usize> = Some(2);
+        assert_eq!(result, expected);
+    }
+
+    #[test]
+    fn mixed_case() {
+        let mut syllable = Syllable::parse("cHÊt").unwrap();
+        syllable.add_tone(&ToneMark::Acute);
+        assert_eq!(syllable.to_string(), "cHẾt");
+        let mut syllable = Syllable::parse("nGuOi").unwrap();
+        syllable.modify_letter(&LetterModification::Horn);
+        syllable.add_tone(&ToneMark::Grave);
+        assert_eq!(syllable.to_string(), "nGưỜi");
+    }
+
+    #[test]
+    fn tone_style_old() {
+        for (word, expected) in [("hoà", "hòa"), ("khoẻ", "khỏe"), ("thuỳ", "thùy"), ("hoàng", "hoàng"), ("xoòng", "xoòng")].iter() {
+            let mut syllable = Syllable::parse(word).unwrap();
+            syllable.set_tone_style(ToneStyle::Old);
+            assert_eq!(syllable.to_string(), *expected);
+        }
+    }
+
+    #[test]
+    fn modify_letter_after_q() {
+        let mut syllable = Syllable::parse("qu").unwrap();
+        assert!(syllable.modify_letter(&LetterModification::Horn));
+        assert_eq!(syllable.vowel(), 1..2);
+    }
+
+    #[test]
+    fn modify_letter_on_character_family() {
+        let mut syllable = Syllable::parse("toan").unwrap();
+        assert!(syllable.modify_letter_on_character_family(&LetterModification::Circumflex, 'A'));
+        assert_eq!(syllable.to_string(), "toân");
+        assert!(!syllable.modify_letter_on_character_family(&LetterModification::Circumflex, 'a'));
+        assert_eq!(syllable.to_string(), "toan");
+    }
+}
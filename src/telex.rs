@@ -0,0 +1,203 @@
+use std::fmt;
+use phf::phf_map;
+use super::engine::KeyMap;
+use super::method::{InputMethod, KeyOrder};
+use super::processor::{Action, ToneMark, LetterModification};
+
+/// In telex, letters denote an action when they can be applied to the
+/// word typed so far, otherwise they are typed as is. `w` adds a horn to
+/// `u` and `o`, or a breve to `a` when there is nothing to add a horn to.
+pub static TELEX_KEYS: KeyMap = phf_map! {
+    's' => &[Action::AddTone(ToneMark::Acute)],
+    'f' => &[Action::AddTone(ToneMark::Grave)],
+    'r' => &[Action::AddTone(ToneMark::HookAbove)],
+    'x' => &[Action::AddTone(ToneMark::Tilde)],
+    'j' => &[Action::AddTone(ToneMark::Underdot)],
+    'z' => &[Action::RemoveTone],
+    'a' => &[Action::ModifyLetterOnCharacterFamily(LetterModification::Circumflex, 'a')],
+    'e' => &[Action::ModifyLetterOnCharacterFamily(LetterModification::Circumflex, 'e')],
+    'o' => &[Action::ModifyLetterOnCharacterFamily(LetterModification::Circumflex, 'o')],
+    'd' => &[Action::ModifyLetterOnCharacterFamily(LetterModification::Dyet, 'd')],
+    'w' => &[
+        Action::ModifyLetter(LetterModification::Horn),
+        Action::ModifyLetterOnCharacterFamily(LetterModification::Breve, 'a')
+    ],
+    // uppercase
+    'S' => &[Action::AddTone(ToneMark::Acute)],
+    'F' => &[Action::AddTone(ToneMark::Grave)],
+    'R' => &[Action::AddTone(ToneMark::HookAbove)],
+    'X' => &[Action::AddTone(ToneMark::Tilde)],
+    'J' => &[Action::AddTone(ToneMark::Underdot)],
+    'Z' => &[Action::RemoveTone],
+    'A' => &[Action::ModifyLetterOnCharacterFamily(LetterModification::Circumflex, 'a')],
+    'E' => &[Action::ModifyLetterOnCharacterFamily(LetterModification::Circumflex, 'e')],
+    'O' => &[Action::ModifyLetterOnCharacterFamily(LetterModification::Circumflex, 'o')],
+    'D' => &[Action::ModifyLetterOnCharacterFamily(LetterModification::Dyet, 'd')],
+    'W' => &[
+        Action::ModifyLetter(LetterModification::Horn),
+        Action::ModifyLetterOnCharacterFamily(LetterModification::Breve, 'a')
+    ],
+};
+
+/// The telex input method, where keys are applied as they are typed
+pub static TELEX: InputMethod = InputMethod::new(&TELEX_KEYS, KeyOrder::Typed);
+
+/// Transform input buffer to vietnamese string output along with
+/// a bool indicating if an action has been triggered. Unlike vni, keys
+/// are applied in the order they are typed since an action key is also
+/// a letter.
+///
+/// # Example
+/// ```
+/// use vi::telex::transform_buffer;
+///
+/// let result = transform_buffer(&vec!['v', 'i', 'e', 'e', 't', 'j']);
+/// assert_eq!(result, (true, "việt".to_owned()));
+/// ```
+pub fn transform_buffer(buffer: &[char]) -> (bool, String) {
+    TELEX.transform_buffer(buffer)
+}
+
+/// Same as `transform_buffer` but append the output to `output`.
+/// Return if an action has been triggered.
+pub fn transform_buffer_into(buffer: &[char], output: &mut String) -> bool {
+    TELEX.transform_buffer_into(buffer, output)
+}
+
+/// Transform a whole text and write the result to `output`. Words are runs
+/// of letters and numbers, everything else such as spaces and punctuation
+/// is copied as is.
+///
+/// # Example
+/// ```
+/// use vi::telex::transform_into;
+///
+/// let mut result = String::new();
+/// transform_into("Vieetj Nam!", &mut result).unwrap();
+/// assert_eq!(result, "Việt Nam!");
+/// ```
+pub fn transform_into<W: fmt::Write>(input: &str, output: &mut W) -> fmt::Result {
+    TELEX.transform_into(input, output)
+}
+
+/// Transform a whole text and append the result to `output`
+pub fn transform_str(input: &str, output: &mut String) {
+    TELEX.transform_str(input, output)
+}
+
+/// Turn vietnamese text back into the keys typed with telex and append
+/// them to `output`
+///
+/// # Example
+/// ```
+/// use vi::telex::decompose_to_keys;
+///
+/// let mut keys = String::new();
+/// decompose_to_keys("việt", &mut keys);
+/// assert_eq!(keys, "vieejt");
+/// ```
+pub fn decompose_to_keys(input: &str, output: &mut String) {
+    TELEX.decompose_to_keys(input, output)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::engine::Engine;
+
+    fn transform(input: &str) -> String {
+        let (_, result) = transform_buffer(&input.chars().collect::<Vec<char>>());
+        result
+    }
+
+    #[test]
+    fn add_tone_normal() {
+        assert_eq!(transform("hoangf"), "hoàng");
+        assert_eq!(transform("tieengs"), "tiếng");
+    }
+
+    #[test]
+    fn add_tone_failed() {
+        let (has_action, result) = transform_buffer(&vec!['s', 't']);
+        assert_eq!(result, "st");
+        assert_eq!(has_action, false);
+    }
+
+    #[test]
+    fn add_tone_overflow() {
+        assert_eq!(transform("ass"), "as");
+    }
+
+    #[test]
+    fn add_tone_before_vowel_end() {
+        assert_eq!(transform("hofa"), "hoà");
+    }
+
+    #[test]
+    fn remove_tone() {
+        assert_eq!(transform("chaof"), "chào");
+        assert_eq!(transform("chaofz"), "chao");
+    }
+
+    #[test]
+    fn modify_letter_double_key() {
+        assert_eq!(transform("ddaays"), "đấy");
+        assert_eq!(transform("aaa"), "aa");
+        assert_eq!(transform("ddd"), "dd");
+    }
+
+    #[test]
+    fn modify_letter_horn() {
+        assert_eq!(transform("nguoiwf"), "người");
+        assert_eq!(transform("nguwowif"), "người");
+        assert_eq!(transform("muwa"), "mưa");
+    }
+
+    #[test]
+    fn modify_letter_breve() {
+        assert_eq!(transform("awn"), "ăn");
+    }
+
+    #[test]
+    fn modify_letter_uppercase() {
+        assert_eq!(transform("VIEEJT"), "VIỆT");
+        assert_eq!(transform("Truwowngf"), "Trường");
+    }
+
+    #[test]
+    fn skip_non_vietnamese_words() {
+        assert_eq!(transform("hellos"), "hellos");
+        assert_eq!(transform("windows"), "windows");
+        assert_eq!(transform("dogs"), "dogs");
+    }
+
+    #[test]
+    fn transform_str_sentence() {
+        let mut result = String::new();
+        transform_str("xin chaof, tooi laf Hungw", &mut result);
+        assert_eq!(result, "xin chào, tôi là Hưng");
+    }
+
+    #[test]
+    fn engine_same_as_transform_buffer() {
+        for input in ["hoangf", "ass", "hofa", "ddaays", "nguwowif", "Truwowngf"].iter() {
+            let mut engine = Engine::new(&TELEX);
+            for ch in input.chars() {
+                engine.push(ch);
+            }
+            assert_eq!(engine.commit(), transform(input));
+        }
+    }
+
+    #[test]
+    fn decompose_to_keys_round_trip() {
+        for word in ["việt", "đường", "người", "ăn", "mưa", "VIỆT", "Trường"].iter() {
+            let mut keys = String::new();
+            decompose_to_keys(word, &mut keys);
+            assert_eq!(&transform(&keys), word);
+        }
+        let mut keys = String::new();
+        decompose_to_keys("Trường học", &mut keys);
+        assert_eq!(keys, "Truwowfng hojc");
+    }
+}
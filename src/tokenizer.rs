@@ -0,0 +1,124 @@
+use std::ops::Range;
+use super::decomposition::decompose;
+use super::util::to_lowercase;
+
+const VOWELS: [char; 6] = ['a', 'e', 'i', 'o', 'u', 'y'];
+
+/// Char and byte offsets of a part of a word
+#[derive(Debug, Clone, PartialEq, Default)]
+pub struct Span {
+    pub chars: Range<usize>,
+    pub bytes: Range<usize>
+}
+
+/// The parts of a syllable: the initial consonant, the vowel which is the
+/// main sound of the syllable and the final consonant.
+#[derive(Debug, Clone, PartialEq, Default)]
+pub struct SyllableTokens {
+    pub initial_consonant: Span,
+    pub vowel: Span,
+    pub final_consonant: Span
+}
+
+/// A single pass scanner that locate the vowel of a syllable while its
+/// letters are fed one by one. Only the previous letter is kept around to
+/// treat `qu` and `gi` as initial consonants.
+#[derive(Debug, Clone, Copy, PartialEq, Default)]
+pub(crate) struct VowelScanner {
+    index: usize,
+    byte_index: usize,
+    prev_letter: char,
+    start: Option<(usize, usize)>,
+    end: Option<(usize, usize)>
+}
+
+impl VowelScanner {
+    /// Feed the next letter as a lowercase base letter, whether the letter
+    /// carries a modification and its length in bytes
+    pub(crate) fn push(&mut self, letter: char, is_modified: bool, byte_len: usize) {
+        if self.end.is_none() {
+            if VOWELS.contains(&letter) {
+                let is_start_sound = !is_modified && self.index > 0 && (
+                    (letter == 'u' && self.prev_letter == 'q') ||
+                    (letter == 'i' && self.prev_letter == 'g')
+                );
+                if !is_start_sound && self.start.is_none() {
+                    self.start = Some((self.index, self.byte_index));
+                }
+            } else if self.start.is_some() {
+                self.end = Some((self.index, self.byte_index));
+            }
+        }
+        self.prev_letter = letter;
+        self.index += 1;
+        self.byte_index += byte_len;
+    }
+
+    /// Char range of the vowel among the letters fed so far
+    pub(crate) fn vowel(&self) -> Range<usize> {
+        let (start, _) = self.start.unwrap_or((self.index, self.byte_index));
+        let (end, _) = self.end.unwrap_or((self.index, self.byte_index));
+        start..end
+    }
+
+    fn into_tokens(self) -> SyllableTokens {
+        let (start, byte_start) = self.start.unwrap_or((self.index, self.byte_index));
+        let (end, byte_end) = self.end.unwrap_or((self.index, self.byte_index));
+        SyllableTokens {
+            initial_consonant: Span { chars: 0..start, bytes: 0..byte_start },
+            vowel: Span { chars: start..end, bytes: byte_start..byte_end },
+            final_consonant: Span {
+                chars: end..self.index,
+                bytes: byte_end..self.byte_index
+            }
+        }
+    }
+}
+
+/// Split a word into its initial consonant, vowel and final consonant in a
+/// single pass. `qu` and `gi` are treated as initial consonants. A word
+/// without any vowel is all initial consonant.
+///
+/// # Example
+/// ```
+/// use vi::tokenizer::tokenize;
+///
+/// let tokens = tokenize("đường");
+/// assert_eq!(tokens.initial_consonant.chars, 0..1);
+/// assert_eq!(tokens.vowel.chars, 1..3);
+/// assert_eq!(tokens.vowel.bytes, 2..7);
+/// assert_eq!(&"đường"[tokens.final_consonant.bytes], "ng");
+/// ```
+pub fn tokenize(word: &str) -> SyllableTokens {
+    let mut scanner = VowelScanner::default();
+    for ch in word.chars() {
+        let (base, modification, _) = decompose(ch);
+        let (letter, _) = to_lowercase(base);
+        scanner.push(letter, modification.is_some(), ch.len_utf8());
+    }
+    scanner.into_tokens()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn tokenize_no_vowel() {
+        let tokens = tokenize("vt");
+        assert_eq!(tokens.initial_consonant.chars, 0..2);
+        assert!(tokens.vowel.chars.is_empty());
+        assert!(tokens.final_consonant.chars.is_empty());
+    }
+
+    #[test]
+    fn tokenize_start_sound() {
+        assert_eq!(tokenize("QUAN").vowel.chars, 2..3);
+        assert_eq!(tokenize("giếng").vowel.bytes, 2..5);
+    }
+
+    #[test]
+    fn tokenize_horn_after_q() {
+        assert_eq!(tokenize("qươ").vowel.chars, 1..3);
+    }
+}
@@ -1,71 +1,213 @@
-use regex::Regex;
+use std::borrow::Cow;
+use std::mem::size_of;
+use super::decomposition::{decompose, compose};
 
+/// Strip every modification and tone mark from a letter.
+/// For example, `ấ` become `a` and `đ` become `d`.
 pub fn clean_char(ch: char) -> char {
-    let accents = vec![
-        "aàảãáạăằẳẵắặâầẩẫấậ",
-        "AÀẢÃÁẠĂẰẲẴẮẶÂẦẨẪẤẬ",
-        "dđ", "DĐ",
-        "eèẻẽéẹêềểễếệ",
-        "EÈẺẼÉẸÊỀỂỄẾỆ",
-        "iìỉĩíị",
-        "IÌỈĨÍỊ",
-        "oòỏõóọôồổỗốộơờởỡớợ",
-        "OÒỎÕÓỌÔỒỔỖỐỘƠỜỞỠỚỢ",
-        "uùủũúụưừửữứự",
-        "UÙỦŨÚỤƯỪỬỮỨỰ",
-        "yỳỷỹýỵ",
-        "YỲỶỸÝỴ"
-    ];
-    for accent in accents {
-        let regex = Regex::new(&format!("[{}]", &accent[1..]));
-        let replace_char = accent.chars().next().unwrap();
-        if let Ok(re) = regex {
-            if re.is_match(&ch.to_string()) {
-                return replace_char;
+    decompose(ch).0
+}
+
+/// Remove the tone mark of a letter while keeping its modification.
+/// For example, `ấ` become `â`.
+pub fn remove_tone_mark(ch: char) -> char {
+    match decompose(ch) {
+        (base, modification, Some(_)) => compose(base, modification, None),
+        _ => ch
+    }
+}
+
+/// Lowercase a letter if it can be uppercased back to itself.
+/// Return the letter and if it was uppercase.
+pub(crate) fn to_lowercase(ch: char) -> (char, bool) {
+    if ch.is_uppercase() {
+        let mut lower = ch.to_lowercase();
+        if let (Some(lower_ch), None) = (lower.next(), lower.next()) {
+            let mut upper = lower_ch.to_uppercase();
+            if upper.next() == Some(ch) && upper.next().is_none() {
+                return (lower_ch, true);
             }
         }
     }
-    ch
+    (ch, false)
 }
 
-pub fn remove_tone_mark(ch: char) -> char {
-    let tone_mark_map = vec![
-        "aàảãáạ",
-        "ăằẳẵắặ",
-        "âầẩẫấậ",
-        "AÀẢÃÁẠ",
-        "ĂẰẲẴẮẶ",
-        "ÂẦẨẪẤẬ",
-        "eèẻẽéẹ",
-        "êềểễếệ",
-        "EÈẺẼÉẸ",
-        "ÊỀỂỄẾỆ",
-        "iìỉĩíị",
-        "IÌỈĨÍỊ",
-        "oòỏõóọ",
-        "ôồổỗốộ",
-        "ơờởỡớợ",
-        "OÒỎÕÓỌ",
-        "ÔỒỔỖỐỘ",
-        "ƠỜỞỠỚỢ",
-        "uùủũúụ",
-        "ưừửữứự",
-        "UÙỦŨÚỤ",
-        "ƯỪỬỮỨỰ",
-        "yỳỷỹýỵ",
-        "YỲỶỸÝỴ"
-    ];
-    for tone_mark in tone_mark_map {
-        let regex = Regex::new(&format!("[{}]", &tone_mark
-                                        .chars()
-                                        .skip(1)
-                                        .collect::<String>()));
-        let replace_char = tone_mark.chars().next().unwrap();
-        if let Ok(re) = regex {
-            if re.is_match(&ch.to_string()) {
-                return replace_char;
+/// Uppercase a letter that has a single uppercase char, as every
+/// vietnamese letter has
+pub(crate) fn to_uppercase(ch: char) -> char {
+    let mut upper = ch.to_uppercase();
+    match (upper.next(), upper.next()) {
+        (Some(upper_ch), None) => upper_ch,
+        _ => ch
+    }
+}
+
+/// Length of the run of ASCII bytes at the start of `bytes`. Whole words
+/// are checked at once so the scan runs at memchr like speed.
+pub(crate) fn ascii_prefix_len(bytes: &[u8]) -> usize {
+    const WORD: usize = size_of::<usize>();
+    const HIGH_BITS: usize = usize::MAX / 0xff * 0x80;
+    let mut index = 0;
+    while index + WORD <= bytes.len() {
+        let mut word = [0; WORD];
+        word.copy_from_slice(&bytes[index..index + WORD]);
+        if usize::from_ne_bytes(word) & HIGH_BITS != 0 {
+            break;
+        }
+        index += WORD;
+    }
+    index + bytes[index..].iter().take_while(|byte| byte.is_ascii()).count()
+}
+
+/// Length of the run of ASCII bytes outside `low..=high` at the start of
+/// `bytes`. Like `ascii_prefix_len`, whole words are checked at once.
+pub(crate) fn ascii_prefix_len_outside(bytes: &[u8], low: u8, high: u8) -> usize {
+    const WORD: usize = size_of::<usize>();
+    const ONES: usize = usize::MAX / 0xff;
+    const LOW_BITS: usize = ONES * 0x7f;
+    const HIGH_BITS: usize = ONES * 0x80;
+    let outside = |byte: &u8| byte.is_ascii() && !(low..=high).contains(byte);
+    let mut index = 0;
+    // the bytes of a word below 128 that are strictly between low - 1
+    // and high + 1 get their high bit set, without carry across bytes
+    if low > 0 && high < 0x80 {
+        let below_high = ONES * (0x80 + high as usize);
+        let above_low = ONES * (0x80 - low as usize);
+        while index + WORD <= bytes.len() {
+            let mut word = [0; WORD];
+            word.copy_from_slice(&bytes[index..index + WORD]);
+            let word = usize::from_ne_bytes(word);
+            let low_bits = word & LOW_BITS;
+            let in_range = (below_high - low_bits) & !word & (low_bits + above_low);
+            if (word | in_range) & HIGH_BITS != 0 {
+                break;
             }
+            index += WORD;
         }
     }
-    ch
+    index + bytes[index..].iter().take_while(|byte| outside(byte)).count()
+}
+
+/// Check if a char is a combining diacritical mark, as found in text in
+/// decomposed (NFD) form
+fn is_combining_mark(ch: char) -> bool {
+    ('\u{300}'..='\u{36f}').contains(&ch)
+}
+
+fn needs_change(ch: char, lowercase: bool) -> bool {
+    if ch.is_ascii() {
+        return lowercase && ch.is_ascii_uppercase();
+    }
+    is_combining_mark(ch) || clean_char(ch) != ch || (lowercase && ch.is_uppercase())
+}
+
+fn strip(input: &str, lowercase: bool) -> Cow<'_, str> {
+    let bytes = input.as_bytes();
+    let first_change = if lowercase {
+        input.char_indices().find(|(_, ch)| needs_change(*ch, true))
+    } else {
+        let start = ascii_prefix_len(bytes);
+        input[start..].char_indices()
+            .map(|(index, ch)| (start + index, ch))
+            .find(|(_, ch)| needs_change(*ch, false))
+    };
+    let start = match first_change {
+        Some((index, _)) => index,
+        None => return Cow::Borrowed(input)
+    };
+
+    let mut output = String::with_capacity(input.len());
+    output.push_str(&input[..start]);
+    let mut index = start;
+    while index < input.len() {
+        let run = ascii_prefix_len(&bytes[index..]);
+        if run > 0 {
+            let run_start = output.len();
+            output.push_str(&input[index..index + run]);
+            if lowercase {
+                output[run_start..].make_ascii_lowercase();
+            }
+            index += run;
+            continue;
+        }
+        let ch = input[index..].chars().next().unwrap();
+        index += ch.len_utf8();
+        if is_combining_mark(ch) {
+            continue;
+        }
+        let clean = clean_char(ch);
+        if lowercase {
+            output.extend(clean.to_lowercase());
+        } else {
+            output.push(clean);
+        }
+    }
+    Cow::Owned(output)
+}
+
+/// Strip every tone mark and modification from a text, including the
+/// combining marks of decomposed text. The input is borrowed back when
+/// there is nothing to strip.
+///
+/// # Example
+/// ```
+/// use vi::util::strip_diacritics;
+///
+/// assert_eq!(strip_diacritics("Việt Nam"), "Viet Nam");
+/// assert!(matches!(strip_diacritics("Viet Nam"), std::borrow::Cow::Borrowed(_)));
+/// ```
+pub fn strip_diacritics(input: &str) -> Cow<'_, str> {
+    strip(input, false)
+}
+
+/// Same as `strip_diacritics` but also lowercase the text in the same
+/// pass, to build search keys.
+///
+/// # Example
+/// ```
+/// use vi::util::to_search_key;
+///
+/// assert_eq!(to_search_key("Đường Việt Nam"), "duong viet nam");
+/// ```
+pub fn to_search_key(input: &str) -> Cow<'_, str> {
+    strip(input, true)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn ascii_prefix() {
+        assert_eq!(ascii_prefix_len(b""), 0);
+        assert_eq!(ascii_prefix_len(b"hello world, xin chao"), 21);
+        assert_eq!(ascii_prefix_len("hello world, xin chào".as_bytes()), 19);
+    }
+
+    #[test]
+    fn ascii_prefix_outside() {
+        assert_eq!(ascii_prefix_len_outside(b"", b'0', b'9'), 0);
+        assert_eq!(ascii_prefix_len_outside(b"hello world, xin chao2", b'0', b'9'), 21);
+        assert_eq!(ascii_prefix_len_outside("hello world, chào".as_bytes(), b'0', b'9'), 15);
+        assert_eq!(ascii_prefix_len_outside(b"/.--:;@@@@@@@@@@AZ", b'A', b'Z'), 16);
+        assert_eq!(ascii_prefix_len_outside(b"aaaaaaaaaaaaaaaaaaaa", b'0', b'9'), 20);
+    }
+
+    #[test]
+    fn strip_borrowed() {
+        assert!(matches!(strip_diacritics("xin chao"), Cow::Borrowed(_)));
+        assert!(matches!(to_search_key("xin chao"), Cow::Borrowed(_)));
+        assert!(matches!(to_search_key("Xin"), Cow::Owned(_)));
+    }
+
+    #[test]
+    fn strip_text() {
+        assert_eq!(strip_diacritics("Tiếng Việt có dấu, ĐẦY ĐỦ"), "Tieng Viet co dau, DAY DU");
+        assert_eq!(strip_diacritics("vie\u{323}\u{302}t"), "viet");
+    }
+
+    #[test]
+    fn search_key() {
+        assert_eq!(to_search_key("NGƯỜI Việt"), "nguoi viet");
+    }
 }
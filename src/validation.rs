@@ -0,0 +1,153 @@
+use super::decomposition::decompose;
+use super::tokenizer::VowelScanner;
+use super::util::to_lowercase;
+
+/// Longest vietnamese syllable, in letters, as in `nghiêng`
+pub const MAX_VALID_SYLLABLE_LENGTH: usize = 7;
+
+fn is_initial_consonant(initial: &str, complete: bool) -> bool {
+    match initial {
+        "" | "b" | "c" | "ch" | "d" | "g" | "gh" | "gi" | "h" | "k" | "kh" | "l" | "m" |
+        "n" | "ng" | "ngh" | "nh" | "p" | "ph" | "qu" | "r" | "s" | "t" | "th" | "tr" |
+        "v" | "x" => true,
+        "q" => !complete,
+        _ => false
+    }
+}
+
+/// Vowels are matched on their base letters, so that they are still valid
+/// before the modifications are typed. Every prefix of a vowel is a vowel
+/// as well, which keeps half typed words valid.
+fn is_vowel(vowel: &str) -> bool {
+    match vowel {
+        "a" | "e" | "i" | "o" | "u" | "y" |
+        "ai" | "ao" | "au" | "ay" | "eo" | "eu" | "ia" | "ie" | "iu" | "oa" | "oe" |
+        "oi" | "oo" | "ua" | "ue" | "ui" | "uo" | "uu" | "uy" | "ye" |
+        "ieu" | "oai" | "oao" | "oay" | "oeo" | "uay" | "uoi" | "uou" | "uya" | "uye" |
+        "uyu" | "yeu" => true,
+        _ => false
+    }
+}
+
+fn is_final_consonant(final_consonant: &str) -> bool {
+    match final_consonant {
+        "" | "c" | "ch" | "m" | "n" | "ng" | "nh" | "p" | "t" => true,
+        _ => false
+    }
+}
+
+/// `k`, `gh` and `ngh` are only written before `e`, `i` and `y`
+fn is_spelling_valid(initial: &str, vowel: &str) -> bool {
+    match initial {
+        "k" | "gh" | "ngh" => vowel.is_empty() || vowel.starts_with(|ch| "eiy".contains(ch)),
+        _ => true
+    }
+}
+
+/// Check the letters of a word, given as lowercase base letters along with
+/// whether they carry a modification. Chars that are not letters, such as
+/// vni numbers typed as is, are skipped.
+pub(crate) fn check_letters<I>(letters: I, complete: bool) -> bool
+where
+    I: Iterator<Item = (char, bool)>
+{
+    let mut buffer = [0; MAX_VALID_SYLLABLE_LENGTH];
+    let mut len = 0;
+    let mut scanner = VowelScanner::default();
+    for (letter, is_modified) in letters.filter(|(letter, _)| letter.is_alphabetic()) {
+        if len == MAX_VALID_SYLLABLE_LENGTH || !letter.is_ascii_lowercase() {
+            return false;
+        }
+        buffer[len] = letter as u8;
+        len += 1;
+        scanner.push(letter, is_modified, 1);
+    }
+    // only ASCII letters are in the buffer
+    let word = std::str::from_utf8(&buffer[..len]).unwrap();
+    let mut vowel = scanner.vowel();
+    if vowel.is_empty() && word.starts_with("gi") {
+        // the `i` of `gi` is the vowel when nothing else is, as in `gìn`
+        vowel = 1..2;
+    }
+    let (initial, final_consonant) = (&word[..vowel.start], &word[vowel.end..]);
+    let vowel = &word[vowel];
+    if vowel.is_empty() {
+        return !complete && is_initial_consonant(initial, false);
+    }
+    is_initial_consonant(initial, true)
+        && is_vowel(vowel)
+        && is_final_consonant(final_consonant)
+        && is_spelling_valid(initial, vowel)
+}
+
+fn lowercase_letters(word: &str) -> impl Iterator<Item = (char, bool)> + '_ {
+    word.chars().map(|ch| {
+        let (base, modification, _) = decompose(ch);
+        (to_lowercase(base).0, modification.is_some())
+    })
+}
+
+/// Check if a word can still become a vietnamese syllable as more letters
+/// are typed: its initial consonant, vowel and final consonant are all
+/// valid or can be completed. Vowels are checked on their base letters,
+/// so `viet` is valid before it becomes `việt`.
+///
+/// # Example
+/// ```
+/// use vi::validation::is_valid_prefix;
+///
+/// assert!(is_valid_prefix("nguoi"));
+/// assert!(is_valid_prefix("ngh"));
+/// assert!(!is_valid_prefix("hello"));
+/// ```
+pub fn is_valid_prefix(word: &str) -> bool {
+    check_letters(lowercase_letters(word), false)
+}
+
+/// Check if a word is a complete vietnamese syllable
+///
+/// # Example
+/// ```
+/// use vi::validation::is_valid_syllable;
+///
+/// assert!(is_valid_syllable("Quyết"));
+/// assert!(is_valid_syllable("gì"));
+/// assert!(!is_valid_syllable("ngh"));
+/// ```
+pub fn is_valid_syllable(word: &str) -> bool {
+    check_letters(lowercase_letters(word), true)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn valid_syllables() {
+        for word in ["a", "đường", "nghiêng", "khuỷu", "quốc", "giặt", "gìn", "xoay", "oẳn", "Ngoẹo"].iter() {
+            assert!(is_valid_syllable(word), "{}", word);
+        }
+    }
+
+    #[test]
+    fn invalid_syllables() {
+        for word in ["hello", "world", "ka", "gha", "qa", "bcd", "strong", "aeiou", "wa"].iter() {
+            assert!(!is_valid_syllable(word), "{}", word);
+        }
+    }
+
+    #[test]
+    fn valid_prefixes() {
+        for word in ["", "q", "ng", "ngh", "tru", "vie", "chie", "d"].iter() {
+            assert!(is_valid_prefix(word), "{}", word);
+        }
+        assert!(!is_valid_prefix("hel"));
+        assert!(!is_valid_prefix("abcdefgh"));
+    }
+
+    #[test]
+    fn numbers_are_skipped() {
+        assert!(is_valid_prefix("a1"));
+        assert!(!is_valid_prefix("hello1"));
+    }
+}
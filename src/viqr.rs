@@ -0,0 +1,72 @@
+use phf::phf_map;
+use super::engine::KeyMap;
+use super::method::{InputMethod, KeyOrder};
+use super::processor::{Action, ToneMark, LetterModification};
+
+/// In viqr, punctuation marks that look like the diacritics are typed
+/// right after the letter. `dd` gives `đ`.
+pub static VIQR_KEYS: KeyMap = phf_map! {
+    '\'' => &[Action::AddTone(ToneMark::Acute)],
+    '`' => &[Action::AddTone(ToneMark::Grave)],
+    '?' => &[Action::AddTone(ToneMark::HookAbove)],
+    '~' => &[Action::AddTone(ToneMark::Tilde)],
+    '.' => &[Action::AddTone(ToneMark::Underdot)],
+    '^' => &[Action::ModifyLetter(LetterModification::Circumflex)],
+    '+' => &[Action::ModifyLetter(LetterModification::Horn)],
+    '(' => &[Action::ModifyLetter(LetterModification::Breve)],
+    'd' => &[Action::ModifyLetterOnCharacterFamily(LetterModification::Dyet, 'd')],
+    'D' => &[Action::ModifyLetterOnCharacterFamily(LetterModification::Dyet, 'd')],
+};
+
+/// The viqr input method. Since `.` and `?` also end sentences, in a text
+/// they are read as punctuation when they end a word. Typing the mark
+/// twice gives the tone followed by the punctuation.
+///
+/// # Example
+/// ```
+/// use vi::viqr::VIQR;
+///
+/// let mut result = String::new();
+/// VIQR.transform_str("Vie^.t Nam, ddu+o+`ng. Toi di ho.c. Ma..", &mut result);
+/// assert_eq!(result, "Việt Nam, đường. Toi di học. Mạ.");
+/// ```
+pub static VIQR: InputMethod = InputMethod::new(&VIQR_KEYS, KeyOrder::Typed)
+    .with_sentence_marks(&['.', '?']);
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn transform(input: &str) -> String {
+        let buffer: Vec<char> = input.chars().collect();
+        let (_, result) = VIQR.transform_buffer(&buffer);
+        result
+    }
+
+    #[test]
+    fn add_tone() {
+        assert_eq!(transform("hoa`ng"), "hoàng");
+        assert_eq!(transform("chao?"), "chảo");
+    }
+
+    #[test]
+    fn modify_letter() {
+        assert_eq!(transform("a(n"), "ăn");
+        assert_eq!(transform("ddo^'"), "đố");
+        assert_eq!(transform("DDu+o+`ng"), "Đường");
+    }
+
+    #[test]
+    fn sentence_marks() {
+        let mut result = String::new();
+        VIQR.transform_str("Toi di hoc. Tai sao? Ba?\nDa. (ho?i.)", &mut result);
+        assert_eq!(result, "Toi di hoc. Tai sao? Ba?\nDa. (hỏi.)");
+        // a word typed alone keeps its tone
+        assert_eq!(transform("chao?"), "chảo");
+    }
+
+    #[test]
+    fn keys_without_letter() {
+        assert_eq!(transform("'"), "'");
+    }
+}
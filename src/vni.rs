@@ -1,14 +1,26 @@
-use super::processor::{
-    Action, ToneMark, LetterModification,
-    add_tone, remove_tone, modify_letter
+use std::fmt;
+use phf::phf_map;
+use super::engine::KeyMap;
+use super::method::{InputMethod, KeyOrder};
+use super::processor::{Action, ToneMark, LetterModification};
+
+/// In vni, number denote an action like adding tone mark, remove tone mark
+/// and changing letter to modified vietnamese letter.
+pub static VNI_KEYS: KeyMap = phf_map! {
+    '1' => &[Action::AddTone(ToneMark::Acute)],
+    '2' => &[Action::AddTone(ToneMark::Grave)],
+    '3' => &[Action::AddTone(ToneMark::HookAbove)],
+    '4' => &[Action::AddTone(ToneMark::Tilde)],
+    '5' => &[Action::AddTone(ToneMark::Underdot)],
+    '6' => &[Action::ModifyLetter(LetterModification::Circumflex)],
+    '7' => &[Action::ModifyLetter(LetterModification::Horn)],
+    '8' => &[Action::ModifyLetter(LetterModification::Breve)],
+    '9' => &[Action::ModifyLetter(LetterModification::Dyet)],
+    '0' => &[Action::RemoveTone],
 };
 
-fn is_number(ch: char) -> bool {
-    match ch {
-        '0'..='9' => true,
-        _ => false
-    }
-}
+/// The vni input method, where all letters are typed before the numbers
+pub static VNI: InputMethod = InputMethod::new(&VNI_KEYS, KeyOrder::LettersFirst);
 
 /// Transform input buffer to vietnamese string output along with
 /// a bool indicating if an ction has been triggered. For example,
@@ -22,83 +34,59 @@ fn is_number(ch: char) -> bool {
 /// let result = transform_buffer(&vec!['v', 'i', 'e', 't', '6', '5']);
 /// assert_eq!(result, (true, "việt".to_owned()));
 /// ```
-pub fn transform_buffer(buffer: &Vec<char>) -> (bool, String) {
-    let mut content = String::new();
-    let mut actions: Vec<Action> = Vec::new();
-    for ch in buffer {
-        if is_number(*ch) {
-            // in vni, number denote an action like adding tone mark, remove
-            // tone mark and changing letter to modified vietnamese letter.
-            match ch {
-                '1' => actions.push(Action::AddTone(ToneMark::Acute)),
-                '2' => actions.push(Action::AddTone(ToneMark::Grave)),
-                '3' => actions.push(Action::AddTone(ToneMark::HookAbove)),
-                '4' => actions.push(Action::AddTone(ToneMark::Tilde)),
-                '5' => actions.push(Action::AddTone(ToneMark::Underdot)),
-                '6' => actions.push(Action::ModifyLetter(LetterModification::Circumflex)),
-                '7' => actions.push(Action::ModifyLetter(LetterModification::Horn)),
-                '8' => actions.push(Action::ModifyLetter(LetterModification::Breve)),
-                '9' => actions.push(Action::ModifyLetter(LetterModification::Dyet)),
-                '0' => actions.push(Action::RemoveTone),
-                _ => {}
-            }
-        } else {
-            content.push(*ch);
-        }
-    }
+pub fn transform_buffer(buffer: &[char]) -> (bool, String) {
+    VNI.transform_buffer(buffer)
+}
 
-    let action_count = actions.len();
-    let has_action = if content.len() > 0 {
-        action_count > 0
-    } else {
-        false
-    };
-
-    for action in actions {
-        match action {
-            Action::AddTone(tone_mark) => {
-                let (add_success, new_content) = add_tone(&content, &tone_mark);
-
-                content = new_content;
-
-                if !add_success {
-                    let trigger_ch = match tone_mark {
-                        ToneMark::Acute     => '1',
-                        ToneMark::Grave     => '2',
-                        ToneMark::HookAbove => '3',
-                        ToneMark::Tilde     => '4',
-                        ToneMark::Underdot  => '5'
-                    };
-                    content.push(trigger_ch);
-                }
-            }
-            Action::ModifyLetter(modification) => {
-                let (modify_success, new_content) = modify_letter(&content, &modification);
-
-                content = new_content;
-
-                if !modify_success {
-                    let trigger_ch = match modification {
-                        LetterModification::Dyet       => '9',
-                        LetterModification::Breve      => '8',
-                        LetterModification::Horn       => '7',
-                        LetterModification::Circumflex => '6'
-                    };
-                    content.push(trigger_ch);
-                }
-            }
-            Action::RemoveTone => {
-                let new_content = remove_tone(&content);
-                if new_content == content {
-                    content.push('0');
-                } else {
-                    content = new_content;
-                }
-            }
-        }
-    }
+/// Same as `transform_buffer` but append the output to `output`.
+/// Return if an action has been triggered.
+pub fn transform_buffer_into(buffer: &[char], output: &mut String) -> bool {
+    VNI.transform_buffer_into(buffer, output)
+}
+
+/// Transform a whole text and write the result to `output`. Words are runs
+/// of letters and numbers, everything else such as spaces and punctuation
+/// is copied as is.
+///
+/// # Example
+/// ```
+/// use vi::vni::transform_into;
+///
+/// let mut result = String::new();
+/// transform_into("Hung7, Viet65 Nam!", &mut result).unwrap();
+/// assert_eq!(result, "Hưng, Việt Nam!");
+/// ```
+pub fn transform_into<W: fmt::Write>(input: &str, output: &mut W) -> fmt::Result {
+    VNI.transform_into(input, output)
+}
+
+/// Transform a whole text and append the result to `output`
+///
+/// # Example
+/// ```
+/// use vi::vni::transform_str;
+///
+/// let mut result = String::new();
+/// transform_str("xin chao2", &mut result);
+/// assert_eq!(result, "xin chào");
+/// ```
+pub fn transform_str(input: &str, output: &mut String) {
+    VNI.transform_str(input, output)
+}
 
-    (has_action, content)
+/// Turn vietnamese text back into the keys typed with vni and append
+/// them to `output`
+///
+/// # Example
+/// ```
+/// use vi::vni::decompose_to_keys;
+///
+/// let mut keys = String::new();
+/// decompose_to_keys("việt", &mut keys);
+/// assert_eq!(keys, "viet65");
+/// ```
+pub fn decompose_to_keys(input: &str, output: &mut String) {
+    VNI.decompose_to_keys(input, output)
 }
 
 #[cfg(test)]
@@ -219,4 +207,46 @@ mod tests {
         let expected = "chÊ".to_string();
         assert_eq!(result, expected);
     }
+
+    #[test]
+    fn skip_non_vietnamese_words() {
+        let (has_action, result) = transform_buffer(&['h', 'e', 'l', 'l', 'o', '1']);
+        assert_eq!(result, "hello1");
+        assert_eq!(has_action, false);
+    }
+
+    #[test]
+    fn transform_str_sentence() {
+        let input = "xin chao2 toi6 la2 Hung7, toi6 den961 tu72 Viet65 Nam";
+        let mut result = String::new();
+        transform_str(input, &mut result);
+        assert_eq!(result, "xin chào tôi là Hưng, tôi đến từ Việt Nam");
+    }
+
+    #[test]
+    fn transform_str_same_as_transform_buffer() {
+        let inputs = vec![
+            "vit1", "vt1", "hoang23", "23", "a11", "CHAO2", "chet6100",
+            "vit500", "vuon7", "che7", "chE6", "supercalifragilistic1"
+        ];
+        for input in inputs {
+            let mut result = String::new();
+            transform_str(input, &mut result);
+            let (_, expected) = transform_buffer(&input.chars().collect::<Vec<char>>());
+            assert_eq!(result, expected);
+        }
+    }
+
+    #[test]
+    fn decompose_to_keys_round_trip() {
+        for word in ["việt", "đường", "Người", "hoặc", "khuỷu", "QUỐC", "chÊ"].iter() {
+            let mut keys = String::new();
+            decompose_to_keys(word, &mut keys);
+            let (_, result) = transform_buffer(&keys.chars().collect::<Vec<char>>());
+            assert_eq!(&result, word);
+        }
+        let mut keys = String::new();
+        decompose_to_keys("Đường phố, Hà Nội.", &mut keys);
+        assert_eq!(keys, "Duong972 pho61, Ha2 Noi65.");
+    }
 }
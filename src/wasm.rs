@@ -0,0 +1,163 @@
+use wasm_bindgen::prelude::*;
+use super::engine::{Delta, Engine};
+use super::inline::InlineString;
+use super::method::InputMethod;
+use super::{telex, viqr, vni};
+
+fn method_by_name(name: &str) -> Option<&'static InputMethod> {
+    match name {
+        "vni" => Some(&vni::VNI),
+        "telex" => Some(&telex::TELEX),
+        "viqr" => Some(&viqr::VIQR),
+        _ => None
+    }
+}
+
+fn unknown_method(name: &str) -> JsValue {
+    JsValue::from_str(&format!("unknown input method `{}`", name))
+}
+
+/// Transform a whole text typed with `"vni"`, `"telex"` or `"viqr"` in
+/// a single call
+#[wasm_bindgen]
+pub fn transform(method: &str, input: &str) -> Result<String, JsValue> {
+    let method = method_by_name(method).ok_or_else(|| unknown_method(method))?;
+    let mut result = String::with_capacity(input.len());
+    method.transform_str(input, &mut result);
+    Ok(result)
+}
+
+/// The incremental engine for JS, fed with batches of keys.
+///
+/// The deltas of a batch are written to buffers in the wasm memory which
+/// JS reads in place: `deltas` holds a `(backspace_count, insert_len)`
+/// pair of `u32` per key and `inserts` holds the inserted texts one after
+/// the other as UTF-8. Both buffers are reused from one batch to the next,
+/// so their views must be taken again after each call.
+///
+/// ```js
+/// const engine = new WasmEngine("vni");
+/// const count = engine.feed("viet65");
+/// const deltas = new Uint32Array(memory.buffer, engine.deltas_ptr(), count * 2);
+/// const inserts = new Uint8Array(memory.buffer, engine.inserts_ptr(), engine.inserts_len());
+/// ```
+#[wasm_bindgen]
+pub struct WasmEngine {
+    method: &'static InputMethod,
+    engine: Engine,
+    deltas: Vec<u32>,
+    inserts: Vec<u8>
+}
+
+#[wasm_bindgen]
+impl WasmEngine {
+    #[wasm_bindgen(constructor)]
+    pub fn new(method: &str) -> Result<WasmEngine, JsValue> {
+        let method = method_by_name(method).ok_or_else(|| unknown_method(method))?;
+        Ok(WasmEngine::with_method(method))
+    }
+
+    /// Feed a batch of keys and return the number of deltas written, one
+    /// per key. A key that ends a word, such as a space, commits the word
+    /// and is typed as is.
+    pub fn feed(&mut self, keys: &str) -> usize {
+        self.clear();
+        for key in keys.chars() {
+            if self.method.is_word_char(key) {
+                let delta = self.engine.push(key);
+                self.push_delta(&delta);
+            } else {
+                self.engine.reset();
+                let mut insert = InlineString::new();
+                insert.push(key);
+                self.push_delta(&Delta { backspace_count: 0, insert });
+            }
+        }
+        self.deltas.len() / 2
+    }
+
+    /// Remove the last char of the word and return the number of deltas
+    /// written, always one
+    pub fn backspace(&mut self) -> usize {
+        self.clear();
+        let delta = self.engine.backspace();
+        self.push_delta(&delta);
+        1
+    }
+
+    /// Finish the current word, return it and reset the engine
+    pub fn commit(&mut self) -> String {
+        self.engine.commit()
+    }
+
+    /// Get the word being typed
+    pub fn view(&self) -> String {
+        self.engine.view().to_owned()
+    }
+
+    pub fn deltas_ptr(&self) -> *const u32 {
+        self.deltas.as_ptr()
+    }
+
+    pub fn inserts_ptr(&self) -> *const u8 {
+        self.inserts.as_ptr()
+    }
+
+    pub fn inserts_len(&self) -> usize {
+        self.inserts.len()
+    }
+}
+
+impl WasmEngine {
+    pub fn with_method(method: &'static InputMethod) -> Self {
+        WasmEngine {
+            method,
+            engine: Engine::new(method),
+            deltas: Vec::new(),
+            inserts: Vec::new()
+        }
+    }
+
+    fn clear(&mut self) {
+        self.deltas.clear();
+        self.inserts.clear();
+    }
+
+    fn push_delta(&mut self, delta: &Delta) {
+        self.deltas.push(delta.backspace_count as u32);
+        self.deltas.push(delta.insert.len() as u32);
+        self.inserts.extend_from_slice(delta.insert.as_bytes());
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn feed_batch() {
+        let mut engine = WasmEngine::with_method(&vni::VNI);
+        assert_eq!(engine.feed("to6i"), 4);
+        assert_eq!(&engine.deltas[4..6], &[1, 2]);
+        assert_eq!(engine.inserts, "toôi".as_bytes());
+        assert_eq!(engine.view(), "tôi");
+    }
+
+    #[test]
+    fn feed_word_end() {
+        let mut engine = WasmEngine::with_method(&telex::TELEX);
+        engine.feed("as ");
+        assert_eq!(engine.view(), "");
+        assert_eq!(engine.deltas, [0, 1, 1, 2, 0, 1]);
+        assert_eq!(engine.inserts, "aá ".as_bytes());
+    }
+
+    #[test]
+    fn backspace() {
+        let mut engine = WasmEngine::with_method(&vni::VNI);
+        engine.feed("toan2");
+        assert_eq!(engine.backspace(), 1);
+        assert_eq!(engine.deltas, [1, 0]);
+        assert_eq!(engine.commit(), "toà");
+    }
+}
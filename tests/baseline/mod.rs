@@ -0,0 +1,459 @@
+//! A frozen copy of the string processor the crate started from, kept
+//! apart from the crate so the syllable code can be checked against it.
+//!
+//! The algorithm is the original one, with the regexes replaced by the
+//! same tables and the tone placement tests kept along. The rules added
+//! since then are applied on top, each where it is marked `rule:`, so a
+//! difference with the crate is either a bug or a rule missing here.
+//!
+//! Only keystrokes are in its scope: letters typed along with a tone mark
+//! stay where they are typed in the crate and are moved here.
+
+#![allow(dead_code)]
+
+use vi::engine::KeyMap;
+use vi::method::{InputMethod, KeyOrder};
+use vi::processor::{Action, LetterModification, ToneMark};
+use vi::validation::is_valid_prefix;
+
+const VOWELS: [char; 12] = ['a', 'ă', 'â', 'e', 'ê', 'i', 'o', 'ô', 'ơ', 'u', 'ư', 'y'];
+const MODIFIED_VOWELS: [char; 6] = ['ă', 'â', 'ê', 'ô', 'ơ', 'ư'];
+
+// the letter maps, as the letters before and after
+const ACUTE_MAP: (&str, &str) = ("aâăeêioôơuưyAÂĂEÊIOÔƠUƯY", "áấắéếíóốớúứýÁẤẮÉẾÍÓỐỚÚỨÝ");
+const GRAVE_MAP: (&str, &str) = ("aâăeêioôơuưyAÂĂEÊIOÔƠUƯY", "àầằèềìòồờùừỳÀẦẰÈỀÌÒỒỜÙỪỲ");
+const HOOK_ABOVE_MAP: (&str, &str) = ("aâăeêioôơuưyAĂÂEÊOÔƠIUƯY", "ảẩẳẻểỉỏổởủửỷẢẲẨẺỂỎỔỞỈỦỬỶ");
+const TILDE_MAP: (&str, &str) = ("aăâeêoôơiuưyAĂÂEÊOÔƠIUƯY", "ãẵẫẽễõỗỡĩũữỹÃẴẪẼỄÕỖỠĨŨỮỸ");
+const DOT_MAP: (&str, &str) = ("aăâeêoôơiuưyAĂÂEÊOÔƠIUƯY", "ạặậẹệọộợịụựỵẠẶẬẸỆỌỘỢỊỤỰỴ");
+const CIRCUMFLEX_MAP: (&str, &str) = ("aeoAEO", "âêôÂÊÔ");
+const DYET_MAP: (&str, &str) = ("dD", "đĐ");
+const HORN_MAP: (&str, &str) = ("uoUO", "ươƯƠ");
+const BREVE_MAP: (&str, &str) = ("aA", "ăĂ");
+
+const ACCENTS: [&str; 14] = [
+    "aàảãáạăằẳẵắặâầẩẫấậ",
+    "AÀẢÃÁẠĂẰẲẴẮẶÂẦẨẪẤẬ",
+    "dđ", "DĐ",
+    "eèẻẽéẹêềểễếệ",
+    "EÈẺẼÉẸÊỀỂỄẾỆ",
+    "iìỉĩíị",
+    "IÌỈĨÍỊ",
+    "oòỏõóọôồổỗốộơờởỡớợ",
+    "OÒỎÕÓỌÔỒỔỖỐỘƠỜỞỠỚỢ",
+    "uùủũúụưừửữứự",
+    "UÙỦŨÚỤƯỪỬỮỨỰ",
+    "yỳỷỹýỵ",
+    "YỲỶỸÝỴ"
+];
+
+const TONE_MARKS: [&str; 24] = [
+    "aàảãáạ", "ăằẳẵắặ", "âầẩẫấậ", "AÀẢÃÁẠ", "ĂẰẲẴẮẶ", "ÂẦẨẪẤẬ",
+    "eèẻẽéẹ", "êềểễếệ", "EÈẺẼÉẸ", "ÊỀỂỄẾỆ", "iìỉĩíị", "IÌỈĨÍỊ",
+    "oòỏõóọ", "ôồổỗốộ", "ơờởỡớợ", "OÒỎÕÓỌ", "ÔỒỔỖỐỘ", "ƠỜỞỠỚỢ",
+    "uùủũúụ", "ưừửữứự", "UÙỦŨÚỤ", "ƯỪỬỮỨỰ", "yỳỷỹýỵ", "YỲỶỸÝỴ"
+];
+
+fn map_get(map: (&str, &str), ch: char) -> Option<char> {
+    map.0.chars().position(|from| from == ch).and_then(|index| map.1.chars().nth(index))
+}
+
+fn map_has_value(map: (&str, &str), ch: char) -> bool {
+    map.1.chars().any(|to| to == ch)
+}
+
+/// Replace a char by the first char of the group it is in
+fn first_of_group(groups: &[&str], ch: char) -> char {
+    for group in groups {
+        if group.chars().skip(1).any(|other| other == ch) {
+            return group.chars().next().unwrap();
+        }
+    }
+    ch
+}
+
+pub fn clean_char(ch: char) -> char {
+    first_of_group(&ACCENTS, ch)
+}
+
+pub fn remove_tone_mark(ch: char) -> char {
+    first_of_group(&TONE_MARKS, ch)
+}
+
+fn is_vowel(c: char) -> bool {
+    VOWELS.contains(&c)
+}
+
+fn is_modified_vowels(c: char) -> bool {
+    MODIFIED_VOWELS.contains(&c)
+}
+
+/// Get the main sound of a word which is the part that start
+/// with a vowel and end with word end or a non-vowel char
+pub fn get_word_mid(word: &str) -> Option<(usize, String)> {
+    let mut result = String::new();
+    let mut found_word_mid = false;
+    let mut start_index: usize = 0;
+    let lower_word = word.to_lowercase();
+    for (index, ch) in lower_word.chars().enumerate() {
+        if is_vowel(ch) {
+            // rule: `qu` and `gi` are found in any case
+            if ch == 'u' && index > 0 {
+                let prev_ch = lower_word.chars().nth(index - 1).unwrap();
+                if prev_ch == 'q' {
+                    continue; // special case 'qu' is start sound
+                }
+            }
+            if ch == 'i' && index > 0 {
+                let prev_ch = lower_word.chars().nth(index - 1).unwrap();
+                if prev_ch == 'g' {
+                    continue; // special case 'gi' is start sound
+                }
+            }
+            result.push(ch);
+            if !found_word_mid {
+                found_word_mid = true;
+                start_index = index;
+            }
+        } else if found_word_mid {
+            break
+        }
+    }
+    if !found_word_mid {
+        return None
+    }
+    Some((start_index, result))
+}
+
+/// Get position to place tone mark
+///
+/// # Rules:
+/// 1. Tone mark always above vowel (a, ă, â, e, ê, i, o, ô, ơ, u, ư, y)
+/// 2. If a word contains ơ, tone mark goes there
+/// 3. If a modified letter goes with a non-modified vowel, tone mark should be
+/// on modifed letter
+/// 4. If a word contains `oa`, `oe`, `oo`, `oy`, tone mark should be on the
+/// second vowel
+/// 5. If a word end with 2 or 3 vowel, put it on the second last one
+/// 6. Else, but tone mark on whatever vowel comes first
+pub fn get_tone_mark_placement(input: &str) -> Option<usize> {
+    if let Some((mid_index, word_mid)) = get_word_mid(input) {
+        // rule: lengths are counted in chars rather than bytes
+        let mid_len = word_mid.chars().count();
+        let is_end_with_mid = input.chars().count() == mid_index + mid_len;
+        if mid_len == 1 { // single vowel
+            return Some(mid_index);
+        }
+        if let Some(pos) = index_of(&word_mid, |c| c == 'ơ') {
+            return Some(mid_index + pos);
+        }
+        if let Some(pos) = index_of(&word_mid, is_modified_vowels) {
+            return Some(mid_index + pos);
+        }
+        for pair in ["oa", "oe", "oo", "uy"].iter() {
+            if let Some(pos) = has_pair(&word_mid, pair) {
+                return Some(mid_index + pos + 1);
+            }
+        }
+        if is_end_with_mid && mid_len >= 2 {
+            return Some(mid_index + mid_len - 2)
+        }
+        if let Some(pos) = index_of(&word_mid, is_vowel) {
+            return Some(mid_index + pos);
+        }
+    }
+    None
+}
+
+fn has_pair(input: &str, pair: &str) -> Option<usize> {
+    if let (Some(ch), Some(ch_next)) = (pair.chars().next(), pair.chars().nth(1)) {
+        if let Some(pos) = index_of(input, |c| c == ch) {
+            if let Some(target_ch) = input.chars().nth(pos + 1) {
+                if target_ch == ch_next {
+                    return Some(pos);
+                }
+            }
+        }
+    }
+    None
+}
+
+fn index_of<F: Fn(char) -> bool>(input: &str, test: F) -> Option<usize> {
+    input.chars().position(test)
+}
+
+fn replace_char_at(input: &str, index: usize, ch: char) -> String {
+    let mut result: String = input.chars().take(index).collect();
+    result.push(ch);
+    result.push_str(&input.chars().skip(index + 1).collect::<String>());
+    result
+}
+
+fn tone_mark_map(tone_mark: &ToneMark) -> (&'static str, &'static str) {
+    match tone_mark {
+        ToneMark::Acute     => ACUTE_MAP,
+        ToneMark::Grave     => GRAVE_MAP,
+        ToneMark::HookAbove => HOOK_ABOVE_MAP,
+        ToneMark::Tilde     => TILDE_MAP,
+        ToneMark::Underdot  => DOT_MAP
+    }
+}
+
+fn modification_map(modification: &LetterModification) -> (&'static str, &'static str) {
+    match modification {
+        LetterModification::Horn       => HORN_MAP,
+        LetterModification::Breve      => BREVE_MAP,
+        LetterModification::Circumflex => CIRCUMFLEX_MAP,
+        LetterModification::Dyet       => DYET_MAP
+    }
+}
+
+pub fn extract_tone(input: &str) -> Option<ToneMark> {
+    use ToneMark::*;
+    for ch in input.chars() {
+        for tone_mark in [Acute, Grave, HookAbove, Tilde, Underdot].iter() {
+            if map_has_value(tone_mark_map(tone_mark), ch) {
+                return Some(*tone_mark);
+            }
+        }
+    }
+    None
+}
+
+fn extract_letter_modification(input: &str) -> Option<LetterModification> {
+    use LetterModification::*;
+    for ch in input.chars() {
+        for modification in [Horn, Breve, Circumflex, Dyet].iter() {
+            if map_has_value(modification_map(modification), ch) {
+                return Some(*modification);
+            }
+        }
+    }
+    None
+}
+
+/// Add tone mark to input
+/// Return if the tone mark has been added or not and what's the output
+pub fn add_tone(input: &str, tone_mark: &ToneMark) -> (bool, String) {
+    let clean_input = input.chars().map(remove_tone_mark).collect::<String>();
+
+    if let Some(existing_tone) = extract_tone(input) {
+        if existing_tone == *tone_mark {
+            return (false, clean_input);
+        }
+    }
+
+    if let Some(tone_mark_pos) = get_tone_mark_placement(&clean_input) {
+        let tone_mark_ch = clean_input.chars().nth(tone_mark_pos).unwrap();
+        let replace_char = map_get(tone_mark_map(tone_mark), tone_mark_ch).unwrap_or(tone_mark_ch);
+        return (true, replace_char_at(&clean_input, tone_mark_pos, replace_char));
+    }
+    (false, input.to_owned())
+}
+
+/// change a letter to vietnamese modified letter, only the letters of
+/// `family` if there is one
+/// Return if the letter has been modified or not and what's the output
+pub fn modify_letter(input: &str, modification: &LetterModification, family: Option<char>) -> (bool, String) {
+    let map = modification_map(modification);
+    let in_family = |ch: char| family.map_or(true, |family| ch.to_lowercase().eq(family.to_lowercase()));
+
+    // rule: the modification goes on every letter of the family that can
+    // take it and doesn't have it yet, other modifications are replaced
+    let mut modified = false;
+    let mut result = String::new();
+    for ch in input.chars() {
+        let base = clean_char(ch);
+        let target = map_get(map, base).filter(|_| in_family(base));
+        match target {
+            Some(target) if target != remove_tone_mark(ch) => {
+                // rule: the tone mark of the letter is kept
+                let toned = match extract_tone(&ch.to_string()) {
+                    Some(tone_mark) => map_get(tone_mark_map(&tone_mark), target).unwrap_or(target),
+                    None => target
+                };
+                result.push(toned);
+                modified = true;
+            }
+            _ => result.push(ch)
+        }
+    }
+
+    // rule: when no letter changed, the modification is removed from the
+    // letters of the family that have it
+    if !modified {
+        result = input.chars()
+            .map(|ch| {
+                let has_it = extract_letter_modification(&remove_tone_mark(ch).to_string()) == Some(*modification);
+                if has_it && in_family(clean_char(ch)) { clean_modification(ch) } else { ch }
+            })
+            .collect();
+    }
+    // rule: the tone mark follows the new spelling
+    if result != input {
+        replace_tone(&mut result);
+    }
+    (modified, result)
+}
+
+/// Remove the modification of a letter and keep its tone mark
+fn clean_modification(ch: char) -> char {
+    let base = clean_char(ch);
+    match extract_tone(&ch.to_string()) {
+        Some(tone_mark) => map_get(tone_mark_map(&tone_mark), base).unwrap_or(base),
+        None => base
+    }
+}
+
+/// Remove the tone for the letter
+pub fn remove_tone(input: &str) -> String {
+    let new_input: String = input.chars().map(remove_tone_mark).collect();
+    if new_input == *input {
+        return new_input.chars().map(clean_char).collect();
+    }
+    new_input
+}
+
+/// Apply the actions of a key, or append the key if none applies
+fn apply_key(content: &mut String, key: char, actions: &[Action]) -> bool {
+    for action in actions {
+        let (success, new_content) = match action {
+            Action::AddTone(tone_mark) => add_tone(content, tone_mark),
+            Action::ModifyLetter(modification) => modify_letter(content, modification, None),
+            Action::ModifyLetterOnCharacterFamily(modification, family) => {
+                modify_letter(content, modification, Some(*family))
+            }
+            Action::RemoveTone => {
+                let new_content = remove_tone(content);
+                (new_content != *content, new_content)
+            }
+        };
+        let changed = new_content != *content;
+        *content = new_content;
+        if success {
+            return true;
+        }
+        if changed {
+            break;
+        }
+    }
+    content.push(key);
+    false
+}
+
+/// Put the tone mark back in its place after a letter is typed
+pub fn replace_tone(content: &mut String) {
+    if let Some(tone_mark) = extract_tone(content) {
+        let clean: String = content.chars().map(remove_tone_mark).collect();
+        if let (true, toned) = add_tone(&clean, &tone_mark) {
+            *content = toned;
+        }
+    }
+}
+
+/// Check if a char can be typed as a keystroke: ascii or a letter with
+/// a modification but no tone mark
+pub fn is_keystroke(ch: char) -> bool {
+    ch.is_ascii() || (clean_char(ch) != ch && extract_tone(&ch.to_string()).is_none())
+}
+
+/// Transform the keys of a word with an input method
+pub fn transform_buffer(method: &InputMethod, buffer: &[char]) -> (bool, String) {
+    match method.order {
+        KeyOrder::LettersFirst => transform_letters_first(method.keys, buffer),
+        KeyOrder::Typed => transform_typed(method.keys, buffer)
+    }
+}
+
+fn transform_letters_first(keys: &KeyMap, buffer: &[char]) -> (bool, String) {
+    let mut content = String::new();
+    let mut actions = Vec::new();
+    for ch in buffer {
+        match keys.get(ch) {
+            Some(key_actions) => actions.push((*ch, *key_actions)),
+            None => content.push(*ch)
+        }
+    }
+    // rule: words that can't be vietnamese are left as typed
+    if !is_valid_prefix(&content) {
+        return (false, buffer.iter().collect());
+    }
+    let has_action = !content.is_empty() && !actions.is_empty();
+    for (key, key_actions) in actions {
+        apply_key(&mut content, key, key_actions);
+    }
+    (has_action, content)
+}
+
+fn transform_typed(keys: &KeyMap, buffer: &[char]) -> (bool, String) {
+    let mut content = String::new();
+    let mut has_action = false;
+    for ch in buffer {
+        if push_key(keys, &mut content, *ch) {
+            has_action = true;
+        }
+    }
+    (has_action, content)
+}
+
+/// Feed a key typed after `content`, moving the tone mark after the
+/// letters. Return if an action has been applied or not
+pub fn push_key(keys: &KeyMap, content: &mut String, ch: char) -> bool {
+    match keys.get(&ch) {
+        // rule: keys are typed as is once the word can't be vietnamese
+        Some(actions) if is_valid_prefix(content) => {
+            if apply_key(content, ch, actions) {
+                return true;
+            }
+        }
+        _ => content.push(ch)
+    }
+    if ch.is_alphabetic() {
+        replace_tone(content);
+    }
+    false
+}
+
+#[test]
+fn get_word_mid_normal() {
+    assert_eq!(get_word_mid("viet"), Some((1, "ie".to_owned())));
+}
+
+#[test]
+fn get_word_mid_empty() {
+    assert_eq!(get_word_mid("vt"), None);
+}
+
+#[test]
+fn get_word_mid_double_start_tone() {
+    assert_eq!(get_word_mid("quai"), Some((2, "ai".to_owned())));
+}
+
+#[test]
+fn get_word_mid_double_start_tone_2() {
+    assert_eq!(get_word_mid("gia"), Some((2, "a".to_owned())));
+}
+
+#[test]
+fn get_tone_mark_placement_normal() {
+    assert_eq!(get_tone_mark_placement("choe"), Some(3));
+}
+
+#[test]
+fn get_tone_mark_placement_special() {
+    assert_eq!(get_tone_mark_placement("chieu"), Some(3));
+}
+
+#[test]
+fn get_tone_mark_placement_mid_not_end() {
+    assert_eq!(get_tone_mark_placement("hoang"), Some(2));
+}
+
+#[test]
+fn get_tone_mark_placement_u_and_o() {
+    assert_eq!(get_tone_mark_placement("ngươi"), Some(3));
+}
+
+#[test]
+fn get_tone_mark_placement_uppercase() {
+    assert_eq!(get_tone_mark_placement("chÊt"), Some(2));
+}
@@ -0,0 +1,256 @@
+//! Random keystrokes checked against a frozen copy of the string
+//! processor the crate started from, see `baseline`.
+//!
+//! Run with `--features placement-table` too so the table path is checked.
+
+mod baseline;
+
+use std::io::{BufReader, Read};
+use proptest::prelude::*;
+use vi::engine::Engine;
+use vi::method::{InputMethod, KeyOrder, MAX_WORD_LENGTH};
+use vi::processor::{self, LetterModification, ToneMark};
+use vi::stream::VniReader;
+use vi::syllable::MAX_SYLLABLE_LENGTH;
+use vi::{telex, viqr, vni};
+
+/// Letters that make up vietnamese words along with some that don't,
+/// in both cases, followed by the keys of each method
+const LETTERS: &str = "aeiouyAEOUdDqgnhtcmkpĐơ";
+const VNI_KEYS: &str = "0123456789";
+const TELEX_KEYS: &str = "sfrxjzwaeodSFW";
+const VIQR_KEYS: &str = "'`?~.^(+dD";
+
+/// Stands for a backspace in the keys typed to the engine
+const BACKSPACE: char = '\u{8}';
+
+const TONE_MARKS: [ToneMark; 5] = [
+    ToneMark::Acute, ToneMark::Grave, ToneMark::HookAbove, ToneMark::Tilde, ToneMark::Underdot
+];
+const MODIFICATIONS: [LetterModification; 4] = [
+    LetterModification::Horn, LetterModification::Breve, LetterModification::Circumflex, LetterModification::Dyet
+];
+
+/// `vni` with keys applied as typed, the way the engine applies them
+static VNI_TYPED: InputMethod = InputMethod::new(&vni::VNI_KEYS, KeyOrder::Typed);
+
+fn keys(method_keys: &str) -> impl Strategy<Value = Vec<char>> {
+    let alphabet: Vec<char> = LETTERS.chars().chain(method_keys.chars()).collect();
+    prop::collection::vec(prop::sample::select(alphabet), 1..24)
+}
+
+fn check_buffer(method: &InputMethod, keys: &[char]) -> Result<(), TestCaseError> {
+    prop_assert_eq!(method.transform_buffer(keys), baseline::transform_buffer(method, keys));
+    Ok(())
+}
+
+/// The engine matches the baseline with the keys applied as typed, and
+/// replaying its deltas gives the word it holds
+fn check_engine(method: &'static InputMethod, typed: &InputMethod, keys: &[char]) -> Result<(), TestCaseError> {
+    let mut engine = Engine::new(method);
+    let mut screen = String::new();
+    for key in keys {
+        let delta = engine.push(*key);
+        for _ in 0..delta.backspace_count {
+            screen.pop();
+        }
+        screen.push_str(&delta.insert);
+    }
+    let (_, expected) = baseline::transform_buffer(typed, keys);
+    prop_assert_eq!(engine.view(), expected.as_str());
+    prop_assert_eq!(screen, expected);
+    Ok(())
+}
+
+/// Each processor function, and its `_into` variant appending to some
+/// text, matches the baseline on a word that fits in a syllable. Longer
+/// words are left as they are.
+fn check_processor(
+    word: &str,
+    tone_mark: &ToneMark,
+    modification: &LetterModification,
+    family: char
+) -> Result<(), TestCaseError> {
+    let expected = baseline::add_tone(word, tone_mark);
+    let (success, result) = processor::add_tone(word, tone_mark);
+    prop_assert_eq!((success, result.into_owned()), expected.clone());
+    let mut output = String::from("x ");
+    prop_assert_eq!(processor::add_tone_into(word, tone_mark, &mut output), expected.0);
+    prop_assert_eq!(output, format!("x {}", expected.1));
+
+    let expected = baseline::modify_letter(word, modification, None);
+    let (success, result) = processor::modify_letter(word, modification);
+    prop_assert_eq!((success, result.into_owned()), expected.clone());
+    let mut output = String::from("x ");
+    prop_assert_eq!(processor::modify_letter_into(word, modification, &mut output), expected.0);
+    prop_assert_eq!(output, format!("x {}", expected.1));
+
+    let expected = baseline::modify_letter(word, modification, Some(family));
+    let (success, result) = processor::modify_letter_on_character_family(word, modification, family);
+    prop_assert_eq!((success, result.into_owned()), expected.clone());
+    let mut output = String::from("x ");
+    let success = processor::modify_letter_on_character_family_into(word, modification, family, &mut output);
+    prop_assert_eq!(success, expected.0);
+    prop_assert_eq!(output, format!("x {}", expected.1));
+
+    let expected = baseline::remove_tone(word);
+    prop_assert_eq!(processor::remove_tone(word).into_owned(), expected.clone());
+    let mut output = String::from("x ");
+    processor::remove_tone_into(word, &mut output);
+    prop_assert_eq!(output, format!("x {}", expected));
+    Ok(())
+}
+
+/// Check if `after` is `before` with one more letter, the tone mark being
+/// allowed to move
+fn appends(before: &str, after: &str) -> bool {
+    let letters = |word: &str| word.chars().map(baseline::remove_tone_mark).collect::<String>();
+    after.chars().count() == before.chars().count() + 1
+        && letters(after).starts_with(&letters(before))
+        && baseline::extract_tone(after) == baseline::extract_tone(before)
+}
+
+/// The engine matches the baseline typing the same keys on a string. A
+/// backspace after a key that appended a letter goes back to the word
+/// before the key. Any other removes the last char, puts the tone mark
+/// back in its place and forgets the keys typed so far, as does a word
+/// too long for a syllable.
+fn check_engine_backspace(method: &'static InputMethod, keys: &[char]) -> Result<(), TestCaseError> {
+    let mut engine = Engine::new(method);
+    let mut screen = String::new();
+    let mut expected = String::new();
+    let mut history: Vec<(String, bool)> = Vec::new();
+    for key in keys {
+        let delta = if *key == BACKSPACE {
+            match history.pop() {
+                Some((before, true)) => expected = before,
+                _ => {
+                    history.clear();
+                    expected.pop();
+                    if expected.chars().count() <= MAX_SYLLABLE_LENGTH {
+                        baseline::replace_tone(&mut expected);
+                    }
+                }
+            }
+            engine.backspace()
+        } else {
+            let before = expected.clone();
+            baseline::push_key(method.keys, &mut expected, *key);
+            let fits = expected.chars().count() <= MAX_SYLLABLE_LENGTH;
+            if fits && before.chars().count() <= MAX_SYLLABLE_LENGTH {
+                let appended = appends(&before, &expected);
+                history.push((before, appended));
+            } else {
+                history.clear();
+            }
+            engine.push(*key)
+        };
+        for _ in 0..delta.backspace_count {
+            screen.pop();
+        }
+        screen.push_str(&delta.insert);
+        prop_assert_eq!(engine.view(), expected.as_str());
+        prop_assert_eq!(&screen, &expected);
+    }
+    Ok(())
+}
+
+proptest! {
+    #[test]
+    fn processor_same_as_baseline(
+        letters in prop::collection::vec(prop::sample::select(LETTERS.chars().collect::<Vec<_>>()), 1..MAX_SYLLABLE_LENGTH),
+        tone_mark in prop::sample::select(TONE_MARKS.to_vec()),
+        modification in prop::sample::select(MODIFICATIONS.to_vec()),
+        family in prop::sample::select(vec!['a', 'e', 'o', 'u', 'd'])
+    ) {
+        let word: String = letters.iter().collect();
+        check_processor(&word, &tone_mark, &modification, family)?;
+        let (_, toned) = baseline::add_tone(&word, &tone_mark);
+        check_processor(&toned, &tone_mark, &modification, family)?;
+    }
+
+    #[test]
+    fn engine_backspace_same_as_baseline(
+        vni_keys in keys("0123456789\u{8}\u{8}\u{8}"),
+        telex_keys in keys("sfrxjzwaeodSFW\u{8}\u{8}\u{8}")
+    ) {
+        check_engine_backspace(&vni::VNI, &vni_keys)?;
+        check_engine_backspace(&telex::TELEX, &telex_keys)?;
+    }
+
+    #[test]
+    fn vni_mixed_case_same_as_lowercase(
+        letters in keys(""),
+        uppercase in prop::collection::vec(prop::sample::select(vec![false, true]), 24..25),
+        numbers in prop::collection::vec(prop::sample::select(VNI_KEYS.chars().collect::<Vec<_>>()), 0..4)
+    ) {
+        let lowercase: Vec<char> = letters.iter().flat_map(|ch| ch.to_lowercase()).collect();
+        let mixed: Vec<char> = lowercase.iter()
+            .zip(&uppercase)
+            .flat_map(|(ch, uppercase)| if *uppercase { ch.to_uppercase().next() } else { Some(*ch) })
+            .chain(numbers.iter().copied())
+            .collect();
+        let lowercase: Vec<char> = lowercase.into_iter().chain(numbers.iter().copied()).collect();
+        let (has_action, result) = vni::VNI.transform_buffer(&lowercase);
+        let expected: String = result.chars()
+            .zip(uppercase.iter().chain(std::iter::repeat(&false)))
+            .flat_map(|(ch, uppercase)| if *uppercase { ch.to_uppercase().next() } else { Some(ch) })
+            .collect();
+        prop_assert_eq!(vni::VNI.transform_buffer(&mixed), (has_action, expected));
+        check_buffer(&vni::VNI, &mixed)?;
+    }
+
+    #[test]
+    fn vni_same_as_reference(keys in keys(VNI_KEYS)) {
+        check_buffer(&vni::VNI, &keys)?;
+        check_engine(&vni::VNI, &VNI_TYPED, &keys)?;
+    }
+
+    #[test]
+    fn telex_same_as_reference(keys in keys(TELEX_KEYS)) {
+        check_buffer(&telex::TELEX, &keys)?;
+        check_engine(&telex::TELEX, &telex::TELEX, &keys)?;
+    }
+
+    #[test]
+    fn viqr_same_as_reference(keys in keys(VIQR_KEYS)) {
+        check_buffer(&viqr::VIQR, &keys)?;
+        check_engine(&viqr::VIQR, &viqr::VIQR, &keys)?;
+    }
+
+    #[test]
+    fn vni_text_same_as_words(
+        words in prop::collection::vec(keys(VNI_KEYS), 0..8),
+        long_word in prop::collection::vec(
+            prop::sample::select(LETTERS.chars().chain(VNI_KEYS.chars()).collect::<Vec<_>>()),
+            MAX_WORD_LENGTH + 1..MAX_WORD_LENGTH + 64
+        ),
+        long_word_position in 0usize..16,
+        chunk_size in 1usize..320
+    ) {
+        // words too long to be vietnamese, such as hashes, are copied as is
+        let mut words = words;
+        if long_word_position < words.len() {
+            words.insert(long_word_position, long_word);
+        }
+        let text = words.iter().map(|word| word.iter().collect::<String>()).collect::<Vec<_>>().join(" ");
+        let expected = words.iter()
+            .map(|word| {
+                let word_text: String = word.iter().collect();
+                match word_text.len() > MAX_WORD_LENGTH {
+                    true => word_text,
+                    false => baseline::transform_buffer(&vni::VNI, word).1
+                }
+            })
+            .collect::<Vec<_>>()
+            .join(" ");
+        let mut result = String::new();
+        vni::transform_str(&text, &mut result);
+        prop_assert_eq!(&result, &expected);
+
+        let mut reader = VniReader::new(BufReader::with_capacity(chunk_size, text.as_bytes()));
+        let mut streamed = String::new();
+        reader.read_to_string(&mut streamed).unwrap();
+        prop_assert_eq!(streamed, expected);
+    }
+}